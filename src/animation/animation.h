@@ -12,6 +12,7 @@
 #include "../scene_graph.h"
 #include "../utils/transforms.h"
 #include "scheduler.h"
+#include "easing.h"
 
 namespace atk {
 
@@ -75,7 +76,7 @@ namespace atk {
         }
 
         static std::function<float(float)> linear_interpolation() {
-            return [](float val){ return val; };
+            return [](float val){ return EasingUtils::linear(val); };
         }
 
         static std::function<float(float)> reverse(const std::function<float(float)> input) {
@@ -85,20 +86,11 @@ namespace atk {
         }
 
         static std::function<float(float)> ease_out_interpolation() {
-            return [](float val){
-                auto ease_in = val * val;
-                auto ease_out = 1.0f - (1.0f - val) * (1.0f - val);
-
-                return ease_out;
-            };
+            return [](float val){ return EasingUtils::ease_out(val); };
         }
 
         static std::function<float(float)> ease_in_out_interpolation() {
-            return [](float val){
-                auto ease_in = val * val;
-                auto ease_out = 1.0f - (1.0f - val) * (1.0f - val);
-                return std::lerp(ease_in, ease_out, val);
-            };
+            return [](float val){ return EasingUtils::ease_in_out(val); };
         }
     };
 
@@ -0,0 +1,204 @@
+#ifndef ANIMATION_CHANNELS_H
+#define ANIMATION_CHANNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "../scene_graph.h"
+#include "../constants.h"
+#include "../entities/buildable.h"
+#include "../entities/arrow.h"
+#include "../utils/transforms.h"
+#include "easing.h"
+#include "easing_kernels.h"
+
+namespace atk {
+
+    /**
+     * A list of tweens that all write the same kind of property. Values are written through Apply, which is fixed at
+     * compile time. Tweens are stored as parallel arrays so progress, easing and interpolation for the whole channel
+     * are evaluated in bulk by EasingKernels before the values are applied. Targets are dereferenced directly each
+     * update; the shared_ptr only keeps them alive until the tween has finished.
+     */
+    template<typename Target, typename Value, void (*Apply)(Target&, const Value&)>
+    class Channel {
+    private:
+        std::vector<std::shared_ptr<Target>> targets;
+        std::vector<Value> from;
+        std::vector<Value> to;
+        std::vector<float> start_seconds;
+        std::vector<float> end_seconds;
+        std::vector<Easing> easings;
+
+        // scratch buffers reused between updates
+        std::vector<float> progress;
+        std::vector<float> eased;
+        std::vector<Value> values;
+
+    public:
+        void add(std::shared_ptr<Target> target,
+                 const Value& from,
+                 const Value& to,
+                 const float& start_seconds,
+                 const float& end_seconds,
+                 const Easing& easing = Easing::EASE_IN_OUT) {
+            this->targets.push_back(std::move(target));
+            this->from.push_back(from);
+            this->to.push_back(to);
+            this->start_seconds.push_back(start_seconds);
+            this->end_seconds.push_back(end_seconds);
+            this->easings.push_back(easing);
+        }
+
+        void clear() {
+            targets.clear();
+            from.clear();
+            to.clear();
+            start_seconds.clear();
+            end_seconds.clear();
+            easings.clear();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return targets.empty();
+        }
+
+        /**
+         * Applies every tween whose window contains the specified time, in the order they were added. Tweens whose
+         * window has passed apply their end value and are removed, even if they were never seen active.
+         */
+        void update(const float& time_seconds) {
+            auto count = targets.size();
+            if (count == 0) {
+                return;
+            }
+
+            progress.resize(count);
+            eased.resize(count);
+            values.resize(count);
+
+            bool any_finished = false;
+            for (std::size_t i = 0; i < count; i++) {
+                float percent = 1.0f;
+                if (time_seconds <= end_seconds[i] && end_seconds[i] > start_seconds[i]) {
+                    percent = std::max(0.0f, (time_seconds - start_seconds[i]) / (end_seconds[i] - start_seconds[i]));
+                } else if (time_seconds > end_seconds[i]) {
+                    any_finished = true;
+                }
+                progress[i] = percent;
+            }
+
+            EasingKernels::ease(easings.data(), progress.data(), eased.data(), count);
+            interpolate(from.data(), to.data(), eased.data(), values.data(), count);
+
+            for (std::size_t i = 0; i < count; i++) {
+                if (time_seconds >= start_seconds[i]) {
+                    Apply(*targets[i], values[i]);
+                }
+            }
+
+            if (any_finished) {
+                remove_finished(time_seconds);
+            }
+        }
+
+    private:
+        void remove_finished(const float& time_seconds) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < targets.size(); i++) {
+                if (time_seconds > end_seconds[i]) {
+                    continue;
+                }
+                if (kept != i) {
+                    targets[kept] = std::move(targets[i]);
+                    from[kept] = from[i];
+                    to[kept] = to[i];
+                    start_seconds[kept] = start_seconds[i];
+                    end_seconds[kept] = end_seconds[i];
+                    easings[kept] = easings[i];
+                }
+                kept++;
+            }
+
+            targets.resize(kept);
+            from.resize(kept);
+            to.resize(kept);
+            start_seconds.resize(kept);
+            end_seconds.resize(kept);
+            easings.resize(kept);
+        }
+
+        static void interpolate(const float* from, const float* to, const float* v, float* out,
+                                const std::size_t& count) {
+            EasingKernels::lerp(from, to, v, out, count);
+        }
+
+        static void interpolate(const sf::Color* from, const sf::Color* to, const float* v, sf::Color* out,
+                                const std::size_t& count) {
+            EasingKernels::lerp_colors(from, to, v, out, count);
+        }
+    };
+
+    /**
+     * Property writers for the standard channels.
+     */
+    class ChannelWriters {
+    public:
+        /**
+         * translation applied in local coordinates
+         */
+        static void x_translation(SceneNode& node, const float& x) {
+            auto current_y = TransformUtils::get_translation_part(node.transform()).second;
+            TransformUtils::set_translation_part(node.transform(), x, current_y);
+        }
+
+        /**
+         * translation applied in local coordinates
+         */
+        static void y_translation(SceneNode& node, const float& y) {
+            auto current_x = TransformUtils::get_translation_part(node.transform()).first;
+            TransformUtils::set_translation_part(node.transform(), current_x, y);
+        }
+
+        static void build_percent(Buildable& buildable, const float& build_percent) {
+            buildable.set_build_percent(build_percent);
+        }
+
+        template<typename T>
+        static void fill_color(T& target, const sf::Color& color) {
+            target.set_fill_color(color);
+        }
+    };
+
+    /**
+     * Typed tween channels evaluated by the Timeline alongside its scheduled animations.
+     */
+    class Channels {
+    public:
+        Channel<SceneNode, float, &ChannelWriters::x_translation> x_translation;
+        Channel<SceneNode, float, &ChannelWriters::y_translation> y_translation;
+        Channel<Buildable, float, &ChannelWriters::build_percent> build_percent;
+        Channel<Arrow, sf::Color, &ChannelWriters::fill_color<Arrow>> arrow_fill_color;
+
+        void update(const float& time_seconds) {
+            x_translation.update(time_seconds);
+            y_translation.update(time_seconds);
+            build_percent.update(time_seconds);
+            arrow_fill_color.update(time_seconds);
+        }
+
+        void clear() {
+            x_translation.clear();
+            y_translation.clear();
+            build_percent.clear();
+            arrow_fill_color.clear();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return x_translation.empty() && y_translation.empty() && build_percent.empty() && arrow_fill_color.empty();
+        }
+    };
+}
+
+#endif
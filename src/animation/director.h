@@ -1,11 +1,14 @@
 #ifndef ANIMATION_DIRECTOR_H
 #define ANIMATION_DIRECTOR_H
 
+#include <utility>
+
 #include "../scene_graph.h"
 #include "../rendering/renderer.h"
 #include "timeline.h"
 #include "animation.h"
 #include "sfml_clock_timer.h"
+#include "fixed_step_timer.h"
 #include "../utils/sequencer.h"
 
 namespace atk {
@@ -60,25 +63,27 @@ namespace atk {
                 auto local_target = s->world_to_local_transform().transformPoint(world_target_x, world_target_y);
 
                 // current local translation applied to the object
-                auto local_start = TransformUtils::get_translation_part(s->transform());
+                auto local_start = TransformUtils::get_translation_part(std::as_const(*s).transform());
 
                 //std::cout << "Local start: " << local_start.first << ", " << local_start.second << std::endl;
                 //std::cout << "Local target: " << local_target.x << ", " << local_target.y << std::endl;
 
                 auto element_bounds = s->world_bounds_recursive();
 
-                timeline.add(
-                        std::make_unique<FireOnceScheduler>(x_sequencer.start(index), x_sequencer.end(index)),
-                        std::make_unique<InterpolatedAnimation>(
-                            atk::InterpolatedAnimation::ease_in_out_interpolation(),
-                            InterplatedActions::x_translation(
-                                    local_start.first, local_start.first + local_target.x + element_bounds.width * 0.5f, s)));
-                timeline.add(
-                        std::make_unique<FireOnceScheduler>(y_sequencer.start(index), y_sequencer.end(index)),
-                        std::make_unique<InterpolatedAnimation>(
-                                atk::InterpolatedAnimation::ease_in_out_interpolation(),
-                                InterplatedActions::y_translation(
-                                     local_start.second, local_start.second + local_target.y, s)));
+                timeline.channels().x_translation.add(
+                        s,
+                        local_start.first,
+                        local_start.first + local_target.x + element_bounds.width * 0.5f,
+                        x_sequencer.start(index),
+                        x_sequencer.end(index),
+                        Easing::EASE_IN_OUT);
+                timeline.channels().y_translation.add(
+                        s,
+                        local_start.second,
+                        local_start.second + local_target.y,
+                        y_sequencer.start(index),
+                        y_sequencer.end(index),
+                        Easing::EASE_IN_OUT);
 
                 world_target_x += s->world_bounds_recursive().width;
                 world_target_x += spacing;
@@ -97,6 +102,11 @@ namespace atk {
         SceneNodePtr root_node;
         std::shared_ptr<Renderer> renderer;
 
+        /**
+         * content version of the root node when the last frame was rendered
+         */
+        std::optional<std::uint64_t> rendered_version;
+
     public:
         Director(SceneNodePtr root_node,
                  std::shared_ptr<Timeline> timeline,
@@ -117,11 +127,10 @@ namespace atk {
                 if (buildable.has_value()) {
                     if (buildable != nullptr) {
                         buildable.value()->set_build_percent(0.0f);
-                        timeline->add(
-                                std::make_unique<FireOnceScheduler>(sequencer.start(index), sequencer.end(index)),
-                                std::make_unique<atk::InterpolatedAnimation>(
-                                        atk::InterpolatedAnimation::ease_in_out_interpolation(),
-                                        atk::InterplatedActions::set_build_percent(n)));
+                        timeline->channels().build_percent.add(
+                                buildable.value(), 0.0f, 1.0f,
+                                sequencer.start(index), sequencer.end(index),
+                                Easing::EASE_IN_OUT);
                         index++;
                     }
                 }
@@ -138,11 +147,10 @@ namespace atk {
                 if (buildable.has_value()) {
                     if (buildable != nullptr) {
                         buildable.value()->set_build_percent(1.0f);
-                        timeline->add(
-                                std::make_unique<FireOnceScheduler>(sequencer.start(index), sequencer.end(index)),
-                                std::make_unique<atk::InterpolatedAnimation>(
-                                        atk::InterpolatedAnimation::reverse(atk::InterpolatedAnimation::ease_in_out_interpolation()),
-                                        atk::InterplatedActions::set_build_percent(n)));
+                        timeline->channels().build_percent.add(
+                                buildable.value(), 1.0f, 0.0f,
+                                sequencer.start(index), sequencer.end(index),
+                                Easing::EASE_IN_OUT);
                         index++;
                     }
                 }
@@ -160,36 +168,90 @@ namespace atk {
         }
 
         /**
-         * does not wait for any events to finish.
+         * does not wait for any events to finish. While nothing is animating and the scene is unchanged, no frames
+         * are rendered; see play.
          */
         void play_forever(Timer& timer) {
-            timer.restart();
-            while (true) {
-                auto time = timer.get_time_seconds();
-                if (timeline->update(time).all_schedulers_terminated) {
-                    timeline->clear();
-                    // don't return. play forever
-                }
+            run(timer, false);
+        }
 
-                if (!renderer->render(*root_node).was_successful) {
-                    return;
-                }
+        /**
+         * Plays until all scheduled animations have terminated. With a FixedStepTimer the timeline is stepped at
+         * exact multiples of the frame interval, producing identical frames on every run.
+         *
+         * With a timer that runs while idle and a renderer that can wait for input, frames are only rendered while
+         * an animation is active or the scene or view changed. Otherwise the Director blocks until input arrives or
+         * the next scheduled animation starts.
+         */
+        void play(Timer& timer) {
+            run(timer, true);
+        }
+
+        /**
+         * Plays until all scheduled animations have terminated, stepping the timeline at exact multiples of
+         * 1 / frames_per_second regardless of how long each frame takes to render.
+         */
+        void play_fixed_step(const float& frames_per_second, const float& scale = 1.0f) {
+            FixedStepTimer timer(frames_per_second);
+            timer.set_scale(scale);
+            play(timer);
+        }
+
+        /**
+         * Applies the end state of everything scheduled so far without playing it, so the scene is left as play
+         * would leave it. Nothing is rendered.
+         */
+        void skip() {
+            timeline->finish();
+        }
+
+        /**
+         * Renders a single frame of the scene as it is, without updating the timeline.
+         */
+        void show() {
+            if (renderer->render(*root_node).was_successful) {
+                rendered_version = root_node->content_version();
             }
         }
 
-        void play(Timer& timer) {
+    private:
+        void run(Timer& timer, const bool& until_terminated) {
+            bool may_idle = timer.runs_while_idle() && renderer->can_wait_for_input();
+            bool redraw = true;
+
             timer.restart();
             while (true) {
                 auto time = timer.get_time_seconds();
+                auto result = timeline->update(time);
 
-                if (timeline->update(time).all_schedulers_terminated) {
+                if (result.all_schedulers_terminated) {
                     timeline->clear();
-                    return;
+                    if (until_terminated) {
+                        return;
+                    }
+                }
+
+                redraw = redraw || result.animating || root_node->content_version() != rendered_version;
+
+                if (may_idle && !redraw) {
+                    std::optional<float> timeout;
+                    if (result.next_transition_seconds.has_value()) {
+                        timeout = timer.seconds_until(result.next_transition_seconds.value());
+                    }
+
+                    redraw = renderer->wait_for_input(timeout);
+                    continue;
                 }
 
                 if (!renderer->render(*root_node).was_successful) {
                     return;
                 }
+
+                // read after rendering, as drawables may refine their geometry while being drawn
+                rendered_version = root_node->content_version();
+                redraw = false;
+
+                timer.frame_rendered();
             }
         }
 
@@ -0,0 +1,48 @@
+#ifndef ANIMATION_EASING_H
+#define ANIMATION_EASING_H
+
+#include <cstdint>
+
+namespace atk {
+
+    /**
+     * Easing curves mapping 0:1 progress through a schedule window onto 0:1 progress of an animated value.
+     */
+    enum class Easing : std::int32_t {
+        LINEAR,
+        EASE_OUT,
+        EASE_IN_OUT
+    };
+
+    class EasingUtils {
+    public:
+        static float linear(const float& val) {
+            return val;
+        }
+
+        static float ease_out(const float& val) {
+            return 1.0f - (1.0f - val) * (1.0f - val);
+        }
+
+        static float ease_in_out(const float& val) {
+            auto ease_in = val * val;
+            auto ease_out = 1.0f - (1.0f - val) * (1.0f - val);
+            return ease_in + val * (ease_out - ease_in);
+        }
+
+        static float ease(const Easing& easing, const float& val) {
+            switch (easing) {
+                case Easing::LINEAR:
+                    return linear(val);
+                case Easing::EASE_OUT:
+                    return ease_out(val);
+                case Easing::EASE_IN_OUT:
+                    return ease_in_out(val);
+            }
+
+            return val;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef ANIMATION_EASING_KERNELS_H
+#define ANIMATION_EASING_KERNELS_H
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "easing.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace atk {
+
+    static_assert(sizeof(sf::Color) == 4, "colour kernels expect tightly packed RGBA colours");
+
+    /**
+     * Batch versions of the easing curves and interpolations used by animations, operating on whole arrays at once.
+     * Uses AVX or SSE2 when the compiler targets them and falls back to scalar code otherwise. Interpolation is exact
+     * at both ends of the 0:1 range.
+     */
+    class EasingKernels {
+    public:
+        /**
+         * out[i] = ease(easing, progress[i])
+         */
+        static void ease(const Easing& easing, const float* progress, float* out, const std::size_t& count) {
+            std::size_t i = 0;
+
+#if defined(__AVX__)
+            for (; i + 8 <= count; i += 8) {
+                __m256 p = _mm256_loadu_ps(progress + i);
+                __m256 e = easing == Easing::LINEAR ? p : (easing == Easing::EASE_OUT ? ease_out(p) : ease_in_out(p));
+                _mm256_storeu_ps(out + i, e);
+            }
+#endif
+#if defined(__SSE2__)
+            for (; i + 4 <= count; i += 4) {
+                __m128 p = _mm_loadu_ps(progress + i);
+                __m128 e = easing == Easing::LINEAR ? p : (easing == Easing::EASE_OUT ? ease_out(p) : ease_in_out(p));
+                _mm_storeu_ps(out + i, e);
+            }
+#endif
+            for (; i < count; i++) {
+                out[i] = EasingUtils::ease(easing, progress[i]);
+            }
+        }
+
+        /**
+         * out[i] = ease(easings[i], progress[i]), for arrays mixing several easing curves.
+         */
+        static void ease(const Easing* easings, const float* progress, float* out, const std::size_t& count) {
+            std::size_t i = 0;
+
+#if defined(__AVX__)
+            for (; i + 8 <= count; i += 8) {
+                __m256 p = _mm256_loadu_ps(progress + i);
+                __m256 codes = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(easings + i)));
+                __m256 is_out = _mm256_cmp_ps(codes, _mm256_set1_ps((float)Easing::EASE_OUT), _CMP_EQ_OQ);
+                __m256 is_in_out = _mm256_cmp_ps(codes, _mm256_set1_ps((float)Easing::EASE_IN_OUT), _CMP_EQ_OQ);
+
+                __m256 e = _mm256_blendv_ps(p, ease_out(p), is_out);
+                e = _mm256_blendv_ps(e, ease_in_out(p), is_in_out);
+                _mm256_storeu_ps(out + i, e);
+            }
+#endif
+#if defined(__SSE2__)
+            for (; i + 4 <= count; i += 4) {
+                __m128 p = _mm_loadu_ps(progress + i);
+                __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(easings + i));
+                __m128 is_out = _mm_castsi128_ps(_mm_cmpeq_epi32(codes, _mm_set1_epi32((std::int32_t)Easing::EASE_OUT)));
+                __m128 is_in_out = _mm_castsi128_ps(_mm_cmpeq_epi32(codes, _mm_set1_epi32((std::int32_t)Easing::EASE_IN_OUT)));
+
+                __m128 e = select(is_out, ease_out(p), p);
+                e = select(is_in_out, ease_in_out(p), e);
+                _mm_storeu_ps(out + i, e);
+            }
+#endif
+            for (; i < count; i++) {
+                out[i] = EasingUtils::ease(easings[i], progress[i]);
+            }
+        }
+
+        /**
+         * out[i] = (1 - t[i]) * from[i] + t[i] * to[i]
+         */
+        static void lerp(const float* from, const float* to, const float* t, float* out, const std::size_t& count) {
+            std::size_t i = 0;
+
+#if defined(__AVX__)
+            for (; i + 8 <= count; i += 8) {
+                __m256 tv = _mm256_loadu_ps(t + i);
+                __m256 a = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), tv), _mm256_loadu_ps(from + i));
+                __m256 b = _mm256_mul_ps(tv, _mm256_loadu_ps(to + i));
+                _mm256_storeu_ps(out + i, _mm256_add_ps(a, b));
+            }
+#endif
+#if defined(__SSE2__)
+            for (; i + 4 <= count; i += 4) {
+                __m128 tv = _mm_loadu_ps(t + i);
+                __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), tv), _mm_loadu_ps(from + i));
+                __m128 b = _mm_mul_ps(tv, _mm_loadu_ps(to + i));
+                _mm_storeu_ps(out + i, _mm_add_ps(a, b));
+            }
+#endif
+            for (; i < count; i++) {
+                out[i] = (1.0f - t[i]) * from[i] + t[i] * to[i];
+            }
+        }
+
+        /**
+         * Per channel RGBA interpolation, out[i] = lerp(from[i], to[i], t[i]) with t clamped to 0:1 and the result
+         * truncated, as ColorUtils::lerp.
+         */
+        static void lerp_colors(const sf::Color* from, const sf::Color* to, const float* t, sf::Color* out,
+                                const std::size_t& count) {
+            std::size_t i = 0;
+
+#if defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 4 <= count; i += 4) {
+                __m128i from_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+                __m128i to_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+
+                __m128 tv = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(t + i), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+                __m128i from_lo = _mm_unpacklo_epi8(from_bytes, zero);
+                __m128i from_hi = _mm_unpackhi_epi8(from_bytes, zero);
+                __m128i to_lo = _mm_unpacklo_epi8(to_bytes, zero);
+                __m128i to_hi = _mm_unpackhi_epi8(to_bytes, zero);
+
+                __m128i c0 = lerp_color(_mm_unpacklo_epi16(from_lo, zero), _mm_unpacklo_epi16(to_lo, zero), _mm_shuffle_ps(tv, tv, 0x00));
+                __m128i c1 = lerp_color(_mm_unpackhi_epi16(from_lo, zero), _mm_unpackhi_epi16(to_lo, zero), _mm_shuffle_ps(tv, tv, 0x55));
+                __m128i c2 = lerp_color(_mm_unpacklo_epi16(from_hi, zero), _mm_unpacklo_epi16(to_hi, zero), _mm_shuffle_ps(tv, tv, 0xAA));
+                __m128i c3 = lerp_color(_mm_unpackhi_epi16(from_hi, zero), _mm_unpackhi_epi16(to_hi, zero), _mm_shuffle_ps(tv, tv, 0xFF));
+
+                __m128i packed = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+            }
+#endif
+            for (; i < count; i++) {
+                float v = std::clamp(t[i], 0.0f, 1.0f);
+                out[i] = sf::Color(
+                        (sf::Uint8)((1.0f - v) * (float)from[i].r + v * (float)to[i].r),
+                        (sf::Uint8)((1.0f - v) * (float)from[i].g + v * (float)to[i].g),
+                        (sf::Uint8)((1.0f - v) * (float)from[i].b + v * (float)to[i].b),
+                        (sf::Uint8)((1.0f - v) * (float)from[i].a + v * (float)to[i].a));
+            }
+        }
+
+    private:
+#if defined(__AVX__)
+        static __m256 ease_out(const __m256& p) {
+            __m256 one = _mm256_set1_ps(1.0f);
+            __m256 inv = _mm256_sub_ps(one, p);
+            return _mm256_sub_ps(one, _mm256_mul_ps(inv, inv));
+        }
+
+        static __m256 ease_in_out(const __m256& p) {
+            __m256 ease_in = _mm256_mul_ps(p, p);
+            return _mm256_add_ps(ease_in, _mm256_mul_ps(p, _mm256_sub_ps(ease_out(p), ease_in)));
+        }
+#endif
+#if defined(__SSE2__)
+        static __m128 ease_out(const __m128& p) {
+            __m128 one = _mm_set1_ps(1.0f);
+            __m128 inv = _mm_sub_ps(one, p);
+            return _mm_sub_ps(one, _mm_mul_ps(inv, inv));
+        }
+
+        static __m128 ease_in_out(const __m128& p) {
+            __m128 ease_in = _mm_mul_ps(p, p);
+            return _mm_add_ps(ease_in, _mm_mul_ps(p, _mm_sub_ps(ease_out(p), ease_in)));
+        }
+
+        static __m128 select(const __m128& mask, const __m128& a, const __m128& b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        /**
+         * interpolates one colour held as four 32 bit integer lanes, returning truncated integer lanes.
+         */
+        static __m128i lerp_color(const __m128i& from, const __m128i& to, const __m128& t) {
+            __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), t), _mm_cvtepi32_ps(from));
+            __m128 b = _mm_mul_ps(t, _mm_cvtepi32_ps(to));
+            return _mm_cvttps_epi32(_mm_add_ps(a, b));
+        }
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef ANIMATION_FIXED_STEP_TIMER_H
+#define ANIMATION_FIXED_STEP_TIMER_H
+
+#include <cstddef>
+#include "sfml_clock_timer.h"
+
+namespace atk {
+
+    /**
+     * Timer driven by the number of rendered frames rather than the wall clock. The n'th frame after restart() is
+     * always rendered at exactly n / frames_per_second, so playback is deterministic and runs as fast as the
+     * renderer allows.
+     */
+    class FixedStepTimer : public Timer {
+    private:
+        float frames_per_second;
+        float scale = 1.0f;
+        std::size_t frame = 0;
+
+    public:
+        explicit FixedStepTimer(const float& frames_per_second = 60.0f) : frames_per_second(frames_per_second) {
+
+        }
+
+        void set_scale(const float& new_scale) {
+            scale = new_scale;
+        }
+
+        float get_time_seconds() override {
+            // computed from the frame count rather than accumulated, so no rounding error builds up
+            return (float)frame / frames_per_second * scale;
+        }
+
+        void restart() override {
+            frame = 0;
+        }
+
+        void frame_rendered() override {
+            frame++;
+        }
+
+        [[nodiscard]] std::size_t frame_count() const {
+            return frame;
+        }
+    };
+}
+
+#endif
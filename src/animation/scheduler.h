@@ -8,6 +8,7 @@
 #include <set>
 #include <memory>
 #include <utility>
+#include <limits>
 #include <math.h>
 #include "../entities/buildable.h"
 #include "timestamp.h"
@@ -17,6 +18,8 @@ namespace atk {
 
     class Scheduler {
     public:
+        virtual ~Scheduler() = default;
+
         struct ScheduleState {
 
             enum State {
@@ -88,6 +91,77 @@ namespace atk {
          * cause other things to break, but the scheduler should treat it as assumed)
          */
         virtual ScheduleState schedule_state(const Timestamp& timestamp) = 0;
+
+        /**
+         * A single window in which a scheduler is active: PENDING before start, ACTIVE from start to end inclusive
+         * and TERMINATED afterwards. If start_exclusive is set the scheduler is still PENDING at exactly start.
+         */
+        struct ActiveInterval {
+            float start;
+            float end;
+            bool start_exclusive = false;
+        };
+
+        /**
+         * @return the earliest timestamp after the specified one at which schedule_state may report a different state,
+         * or nullopt if this is not known. Used by the Timeline to avoid querying pending schedulers every update;
+         * schedulers without this knowledge are queried every update.
+         */
+        virtual std::optional<Timestamp> next_transition(const Timestamp& timestamp) {
+            auto interval = active_interval();
+            if (!interval.has_value()) {
+                return std::nullopt;
+            }
+
+            return interval_next_transition(interval.value(), timestamp);
+        }
+
+        /**
+         * @return the closed form of this scheduler's activity if it is active in exactly one known interval,
+         * otherwise nullopt. Composed schedulers derive their own interval from this once, rather than querying their
+         * delegates on every call.
+         */
+        virtual std::optional<ActiveInterval> active_interval() const {
+            return std::nullopt;
+        }
+
+        /**
+         * @return true if this scheduler may become pending or active again after reporting TERMINATED. Such
+         * schedulers are kept by the Timeline after terminating rather than being retired.
+         */
+        virtual bool may_recur() const {
+            return false;
+        }
+
+    protected:
+        static ScheduleState interval_state(const ActiveInterval& interval, const Timestamp& timestamp) {
+            if (timestamp.seconds < interval.start ||
+                    (interval.start_exclusive && timestamp.seconds == interval.start)) {
+                return ScheduleState::pending();
+            }
+
+            ScheduleWindow window(
+                    std::make_optional<Timestamp>(interval.start),
+                    std::make_optional<Timestamp>(interval.end),
+                    timestamp);
+
+            if (timestamp.seconds > interval.end) {
+                return ScheduleState::terminated(window);
+            }
+
+            return ScheduleState::active(window);
+        }
+
+        static Timestamp interval_next_transition(const ActiveInterval& interval, const Timestamp& timestamp) {
+            if (timestamp.seconds < interval.start ||
+                    (interval.start_exclusive && timestamp.seconds == interval.start)) {
+                return Timestamp(interval.start);
+            } else if (timestamp.seconds <= interval.end) {
+                return Timestamp(interval.end);
+            }
+
+            return Timestamp(std::numeric_limits<float>::infinity());
+        }
     };
 
     class FireOnceScheduler : public Scheduler {
@@ -104,19 +178,11 @@ namespace atk {
         }
 
         ScheduleState schedule_state(const Timestamp &timestamp) override {
-            if (timestamp.seconds < start_seconds) {
-                return ScheduleState::pending();
-            } else if (timestamp.seconds > end_seconds) {
-                return ScheduleState::terminated(
-                        ScheduleWindow(std::make_optional<Timestamp>(start_seconds),
-                                       std::make_optional<Timestamp>(end_seconds),
-                                       timestamp));
-            }
+            return interval_state(ActiveInterval {start_seconds, end_seconds}, timestamp);
+        }
 
-            return ScheduleState::active(ScheduleWindow(
-                    std::optional<Timestamp>(start_seconds),
-                    std::optional<Timestamp>(end_seconds),
-                    timestamp));
+        std::optional<ActiveInterval> active_interval() const override {
+            return ActiveInterval {start_seconds, end_seconds};
         }
 
     };
@@ -142,6 +208,32 @@ namespace atk {
 
             return delegate->schedule_state(modified_timestamp);
         }
+
+        /**
+         * within each repetition the delegate can only change state at its own start and end, or when the
+         * repetition wraps around.
+         */
+        std::optional<Timestamp> next_transition(const Timestamp &timestamp) override {
+            auto delegate_interval = delegate->active_interval();
+            if (!delegate_interval.has_value()) {
+                return std::nullopt;
+            }
+
+            float phase = std::fmod(timestamp.seconds, interval);
+            float repetition_start = timestamp.seconds - phase;
+
+            for (const auto& boundary : {delegate_interval->start, delegate_interval->end, interval}) {
+                if (boundary > phase) {
+                    return Timestamp(repetition_start + boundary);
+                }
+            }
+
+            return Timestamp(repetition_start + interval);
+        }
+
+        bool may_recur() const override {
+            return true;
+        }
     };
 
     class PingPongScheduler : public Scheduler {
@@ -171,6 +263,39 @@ namespace atk {
 
             return delegate->schedule_state(modified_timestamp);
         }
+
+        /**
+         * the delegate's start and end are crossed once on the way forward and once on the way back of every cycle.
+         */
+        std::optional<Timestamp> next_transition(const Timestamp &timestamp) override {
+            auto delegate_interval = delegate->active_interval();
+            if (!delegate_interval.has_value()) {
+                return std::nullopt;
+            }
+
+            float phase = std::fmod(timestamp.seconds, 2.0 * interval);
+            float cycle_start = timestamp.seconds - phase;
+
+            float boundaries[] = {
+                    delegate_interval->start,
+                    delegate_interval->end,
+                    2.0f * interval - delegate_interval->end,
+                    2.0f * interval - delegate_interval->start,
+                    2.0f * interval };
+
+            float next = 2.0f * interval;
+            for (const auto& boundary : boundaries) {
+                if (boundary > phase) {
+                    next = std::min(next, boundary);
+                }
+            }
+
+            return Timestamp(cycle_start + next);
+        }
+
+        bool may_recur() const override {
+            return true;
+        }
     };
 
     class DelayScheduler : public Scheduler {
@@ -179,21 +304,51 @@ namespace atk {
 
         float delay;
 
+        std::optional<ActiveInterval> interval;
+
     public:
 
         DelayScheduler(const float& delay, std::unique_ptr<Scheduler> delegate) :
                 delegate(std::move(delegate)), delay(delay) {
 
+            auto delegate_interval = this->delegate->active_interval();
+            if (delegate_interval.has_value()) {
+                interval = ActiveInterval {
+                        delegate_interval->start + delay,
+                        delegate_interval->end + delay,
+                        delegate_interval->start_exclusive };
+            }
         }
 
         /**
          * "trick" the delegate scheduler into thinking it is being re-fired over and over.
          */
         ScheduleState schedule_state(const Timestamp &timestamp) override {
+            if (interval.has_value()) {
+                return interval_state(interval.value(), timestamp);
+            }
+
             Timestamp modified_timestamp(timestamp.seconds - delay);
 
             return delegate->schedule_state(modified_timestamp);
         }
+
+        std::optional<Timestamp> next_transition(const Timestamp &timestamp) override {
+            if (interval.has_value()) {
+                return interval_next_transition(interval.value(), timestamp);
+            }
+
+            auto next = delegate->next_transition(Timestamp(timestamp.seconds - delay));
+            return next.has_value() ? std::make_optional<Timestamp>(next->seconds + delay) : std::nullopt;
+        }
+
+        std::optional<ActiveInterval> active_interval() const override {
+            return interval;
+        }
+
+        bool may_recur() const override {
+            return delegate->may_recur();
+        }
     };
 
     /**
@@ -207,13 +362,29 @@ namespace atk {
 
         std::string name;
 
+        std::optional<ActiveInterval> interval;
+
     public:
         SequencedScheduler(std::shared_ptr<Scheduler> first, std::shared_ptr<Scheduler> delegate, std::string name) :
                 first(std::move(first)), delegate(std::move(delegate)), name(name) {
 
+            // the delegate's timeline starts once the first scheduler's interval has ended
+            auto first_interval = this->first->active_interval();
+            auto delegate_interval = this->delegate->active_interval();
+            if (first_interval.has_value() && delegate_interval.has_value() && delegate_interval->start >= 0) {
+                float offset = first_interval->end;
+                interval = ActiveInterval {
+                        delegate_interval->start + offset,
+                        delegate_interval->end + offset,
+                        delegate_interval->start_exclusive || delegate_interval->start == 0 };
+            }
         }
 
         ScheduleState schedule_state(const Timestamp &timestamp) override {
+            if (interval.has_value()) {
+                return interval_state(interval.value(), timestamp);
+            }
+
             auto first_schedule = first->schedule_state(timestamp);
 
 
@@ -238,6 +409,14 @@ namespace atk {
 
             return result;
         }
+
+        std::optional<ActiveInterval> active_interval() const override {
+            return interval;
+        }
+
+        bool may_recur() const override {
+            return first->may_recur() || delegate->may_recur();
+        }
     };
 }
 
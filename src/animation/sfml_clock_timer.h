@@ -1,6 +1,7 @@
 #ifndef ANIMATION_SFML_CLOCK_TIMER_H
 #define ANIMATION_SFML_CLOCK_TIMER_H
 
+#include <algorithm>
 #include <functional>
 #include <SFML/Graphics.hpp>
 
@@ -9,6 +10,29 @@ namespace atk {
     public:
         virtual float get_time_seconds() = 0;
         virtual void restart() = 0;
+
+        /**
+         * Invoked by the Director after every rendered frame. Timers that are not driven by the wall clock advance
+         * here.
+         */
+        virtual void frame_rendered() {
+
+        }
+
+        /**
+         * @return true if time passes while no frames are rendered, so the Director may stop rendering while nothing
+         * changes
+         */
+        [[nodiscard]] virtual bool runs_while_idle() const {
+            return false;
+        }
+
+        /**
+         * @return wall clock seconds until the timer reaches the specified time. Only used if runs_while_idle.
+         */
+        virtual float seconds_until(const float& /* time_seconds */) {
+            return 0.0f;
+        }
     };
 
     class SFMLClockTimer : public Timer {
@@ -27,6 +51,14 @@ namespace atk {
         void restart() override {
             clock.restart();
         }
+
+        [[nodiscard]] bool runs_while_idle() const override {
+            return true;
+        }
+
+        float seconds_until(const float& time_seconds) override {
+            return std::max(0.0f, (time_seconds - get_time_seconds()) / scale);
+        }
     };
 }
 
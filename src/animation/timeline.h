@@ -8,97 +8,268 @@
 #include <set>
 #include <memory>
 #include <utility>
+#include <vector>
+#include <algorithm>
+#include <limits>
 #include "../entities/buildable.h"
 #include "scheduler.h"
+#include "channels.h"
 
 namespace atk {
 
     /**
      * Collects and coordinates animations using schedulers.
+     *
+     * Schedulers are tracked as pending, active or retired. Pending schedulers that can report their next transition
+     * are only queried once it has been reached, active schedulers are queried every update and schedulers that have
+     * terminated are retired and never queried again, unless they report that they may recur. Time is assumed to
+     * increase between updates until the timeline is cleared.
      */
     class Timeline {
     public:
         struct UpdateResult {
             bool all_schedulers_terminated;
+
+            /**
+             * true if any animation or tween may change the scene on the next update, regardless of how soon it
+             * happens
+             */
+            bool animating;
+
+            /**
+             * time of the next transition of an animation that is waiting to start or recur, if any
+             */
+            std::optional<float> next_transition_seconds;
         };
 
     private:
         using SchedulerPtr = std::shared_ptr<Scheduler>;
         using AnimPtr = std::shared_ptr<Animation>;
 
-        std::map<SchedulerPtr, AnimPtr> timeline;
-        std::vector<SchedulerPtr> timeline_key_order;
+        struct Entry {
+            SchedulerPtr scheduler;
+            AnimPtr animation;
+
+            /**
+             * window of the most recent activation, present from activation until termination.
+             */
+            std::optional<ScheduleWindow> active_window;
+
+            /**
+             * set while a recurring scheduler waits in pending after reporting TERMINATED.
+             */
+            bool terminated = false;
+        };
+
+        /**
+         * all entries in the order they were added, which is also the order in which animations are applied.
+         */
+        std::vector<Entry> entries;
+
+        /**
+         * pending entries keyed by the time of their next transition
+         */
+        std::multimap<float, std::size_t> pending;
+
+        /**
+         * pending entries without a known transition time, queried every update.
+         */
+        std::vector<std::size_t> polled;
+
+        std::vector<std::size_t> active;
 
-        std::map<AnimPtr, ScheduleWindow> active_animations;
+        /**
+         * number of entries in pending that reported TERMINATED when they were last queried.
+         */
+        std::size_t terminated_pending_count = 0;
+
+        // per update scratch storage, kept to avoid reallocation
+        std::vector<std::size_t> candidates;
+        std::vector<std::pair<std::size_t, Scheduler::ScheduleState>> states;
+
+        Channels _channels;
 
     public:
 
+        /**
+         * Typed tweens, applied after the scheduled animations on every update. Prefer these over
+         * InterpolatedAnimation for the properties they cover.
+         */
+        Channels& channels() {
+            return _channels;
+        }
+
         void clear() {
-            timeline.clear();
-            timeline_key_order.clear();
-            active_animations.clear();
+            entries.clear();
+            pending.clear();
+            polled.clear();
+            active.clear();
+            terminated_pending_count = 0;
+            _channels.clear();
         }
 
         UpdateResult update(float new_time_seconds) {
             const Timestamp timestamp {new_time_seconds};
 
+            candidates.clear();
+            candidates.insert(candidates.end(), active.begin(), active.end());
+            candidates.insert(candidates.end(), polled.begin(), polled.end());
+            while (!pending.empty() && pending.begin()->first <= new_time_seconds) {
+                auto index = pending.begin()->second;
+                if (entries[index].terminated) {
+                    entries[index].terminated = false;
+                    terminated_pending_count--;
+                }
+
+                candidates.push_back(index);
+                pending.erase(pending.begin());
+            }
+
+            // keep the order in which animations were added
+            std::sort(candidates.begin(), candidates.end());
+
+            active.clear();
+            polled.clear();
+
+            states.clear();
+            for (const auto &index : candidates) {
+                states.emplace_back(index, entries[index].scheduler->schedule_state(timestamp));
+            }
+
             /**
              * First iterate over terminated animations, to allow them to set their end
              * states.
              */
-            std::set<SchedulerPtr> terminated_schedulers;
-            for (const auto& scheduler_ptr : timeline_key_order) {
-
-
-                auto anim_ptr = timeline[scheduler_ptr];
-
-                auto schedule_state = scheduler_ptr->schedule_state(timestamp);
-                if (schedule_state.state == Scheduler::ScheduleState::TERMINATED) {
-                    terminated_schedulers.insert(scheduler_ptr);
+            for (auto &kv : states) {
+                if (kv.second.state != Scheduler::ScheduleState::TERMINATED) {
+                    continue;
+                }
 
-                    if (active_animations.contains(anim_ptr)) {
-                        anim_ptr->terminate(active_animations.at(anim_ptr));
-                        active_animations.erase(anim_ptr);
-                    }
+                auto &entry = entries[kv.first];
+                if (entry.active_window.has_value()) {
+                    entry.animation->terminate(entry.active_window.value());
+                    entry.active_window = std::nullopt;
+                }
 
+                // anything else is retired by not being tracked any further
+                if (entry.scheduler->may_recur()) {
+                    schedule_pending(kv.first, timestamp, true);
                 }
             }
 
             bool all_terminated = true;
 
-            for (const auto& scheduler_ptr : timeline_key_order) {
-                auto anim_ptr = timeline[scheduler_ptr];
+            for (auto &kv : states) {
+                auto &entry = entries[kv.first];
+                auto &schedule_state = kv.second;
 
-                if (terminated_schedulers.contains(scheduler_ptr)) {
+                if (schedule_state.state == Scheduler::ScheduleState::TERMINATED) {
                     // terminated. nothing to do.
                     continue;
                 }
 
                 all_terminated = false;
-                auto schedule_state = scheduler_ptr->schedule_state(timestamp);
 
                 if (schedule_state.state == Scheduler::ScheduleState::ACTIVE) {
 
                     // activate the animation if this is it's first ACTIVE frame
-                    if (!active_animations.contains(anim_ptr)) {
-                        anim_ptr->activate(schedule_state.window_if_present.value());
+                    if (!entry.active_window.has_value()) {
+                        entry.animation->activate(schedule_state.window_if_present.value());
                     }
 
-                    anim_ptr->animate(schedule_state.window_if_present.value());
-                    active_animations.emplace(anim_ptr, schedule_state.window_if_present.value());
-                } else if (schedule_state.state != Scheduler::ScheduleState::PENDING) {
+                    entry.animation->animate(schedule_state.window_if_present.value());
+                    entry.active_window = schedule_state.window_if_present.value();
+                    active.push_back(kv.first);
+                } else if (schedule_state.state == Scheduler::ScheduleState::PENDING) {
+                    schedule_pending(kv.first, timestamp);
+                } else {
                     throw std::runtime_error("Internal error");
                 }
             }
 
-            return UpdateResult {all_terminated};
+            _channels.update(new_time_seconds);
+
+            all_terminated = all_terminated && pending.size() == terminated_pending_count && _channels.empty();
+
+            std::optional<float> next_transition;
+            if (!pending.empty()) {
+                next_transition = pending.begin()->first;
+            }
+
+            return UpdateResult {
+                    all_terminated,
+                    !active.empty() || !polled.empty() || !_channels.empty(),
+                    next_transition};
+        }
+
+        /**
+         * Brings every animation and tween to its end state at once, then clears the timeline. Animations that were
+         * never activated are activated and terminated on their closed form interval. Animations without one, and
+         * recurring animations that are not active, have no end state and are dropped.
+         */
+        void finish() {
+            candidates.clear();
+            candidates.insert(candidates.end(), active.begin(), active.end());
+            candidates.insert(candidates.end(), polled.begin(), polled.end());
+            for (const auto &kv : pending) {
+                if (!entries[kv.second].terminated) {
+                    candidates.push_back(kv.second);
+                }
+            }
+
+            // keep the order in which animations were added
+            std::sort(candidates.begin(), candidates.end());
+
+            for (const auto &index : candidates) {
+                auto &entry = entries[index];
+
+                if (entry.active_window.has_value()) {
+                    entry.animation->terminate(entry.active_window.value());
+                    continue;
+                }
+
+                auto interval = entry.scheduler->active_interval();
+                if (!interval.has_value() || entry.scheduler->may_recur()) {
+                    continue;
+                }
+
+                ScheduleWindow window(Timestamp {interval->start}, Timestamp {interval->end}, Timestamp {interval->end});
+                entry.animation->activate(window);
+                entry.animation->terminate(window);
+            }
+
+            _channels.update(std::numeric_limits<float>::infinity());
+
+            clear();
         }
 
         void add(const std::shared_ptr<Scheduler>& scheduler, std::shared_ptr<Animation> animation) {
-            timeline[scheduler] = std::move(animation);
-            timeline_key_order.push_back(scheduler);
+            entries.push_back(Entry {scheduler, std::move(animation), std::nullopt});
+
+            // schedulers with a closed form interval need not be queried before it starts, anything else is
+            // queried on the next update to determine its initial state
+            auto interval = scheduler->active_interval();
+            pending.emplace(
+                    interval.has_value() ? interval->start : -std::numeric_limits<float>::infinity(),
+                    entries.size() - 1);
+        }
+
+    private:
+        void schedule_pending(const std::size_t& index, const Timestamp& timestamp, const bool& terminated = false) {
+            auto next = entries[index].scheduler->next_transition(timestamp);
+
+            if (next.has_value()) {
+                pending.emplace(next->seconds, index);
+
+                if (terminated) {
+                    entries[index].terminated = true;
+                    terminated_pending_count++;
+                }
+            } else {
+                polled.push_back(index);
+            }
         }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
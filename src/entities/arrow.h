@@ -2,12 +2,14 @@
 #define ENTITIES_ARROW_H
 
 #include "buildable.h"
+#include "batchable.h"
 #include "../utils/bounds.h"
 #include "../utils/proportional_quantity.h"
+#include "../rendering/level_of_detail.h"
 
 namespace atk {
 
-    class Arrow: public sf::Drawable, public atk::LocalBoundable, public atk::Buildable {
+    class Arrow: public sf::Drawable, public atk::LocalBoundable, public atk::Buildable, public atk::Batchable {
 
         bool _draw_head = true;
 
@@ -26,6 +28,35 @@ namespace atk {
         ProportionalQuantity head_thickness = ProportionalQuantity(std::nullopt, std::nullopt, 0.1f, 0.0f);
         ProportionalQuantity head_undercut = ProportionalQuantity(std::nullopt, std::nullopt, 0.05f, 0.0f);
 
+        /**
+         * everything the body depends on. The body is rebuilt only when this differs from the key it was built for.
+         */
+        struct BodyKey {
+            std::uint64_t head_version;
+            std::uint64_t tail_version;
+            std::uint64_t parent_version;
+            float build_percent;
+            sf::Color fill_color;
+            bool draw_head;
+            float screen_scale;
+
+            bool operator==(const BodyKey&) const = default;
+        };
+
+        mutable std::optional<BodyKey> body_key;
+
+        /**
+         * incremented whenever the body is rebuilt
+         */
+        mutable std::uint64_t body_revision = 0;
+        mutable sf::VertexArray body;
+        mutable sf::Transform body_transform;
+        mutable sf::FloatRect body_bounds;
+
+        /**
+         * pixels per local unit, rounded to a power of two, that the arrow was last drawn at
+         */
+        mutable float screen_scale = 1.0f;
 
     public:
         Arrow(const std::shared_ptr<SceneNode>& parent,
@@ -38,10 +69,12 @@ namespace atk {
 
         void set_draw_head(const bool& draw_head) {
             this->_draw_head = draw_head;
+            bounds_changed();
         }
 
         void set_fill_color(sf::Color fill_color) {
             _fill_color = fill_color;
+            appearance_changed();
         }
 
         sf::Color get_fill_color() {
@@ -54,36 +87,116 @@ namespace atk {
 
         void set_build_percent(const float &new_build_percent) override {
             this->build_percent = new_build_percent;
+            bounds_changed();
+        }
+
+        /**
+         * bounds follow the head and tail targets
+         */
+        [[nodiscard]] bool has_external_bounds_dependencies() const override {
+            return true;
+        }
+
+        /**
+         * Sum of the world versions of the targets and the parent, and of the body revision, so that it changes
+         * whenever any of them does, as none of them ever decreases. Body rebuilds are counted since the head may be
+         * dropped when the arrow is drawn at a different screen scale.
+         */
+        [[nodiscard]] std::uint64_t bounds_version() const override {
+            return head_target.lock()->world_transform_version()
+                   + tail_target.lock()->world_transform_version()
+                   + parent.lock()->world_transform_version()
+                   + body_revision;
         }
 
         sf::FloatRect get_local_bounds() override {
-            sf::VertexArray body;
-            sf::Transform t;
-            construct_body(body, t);
+            update_body();
+            return body_bounds;
+        }
+
+        void batch(VertexBatch &batch, const sf::Transform &transform) const override {
+            update_body_at_scale(
+                    LevelOfDetail::quantize(batch.view_scale() * TransformUtils::get_scale_factor(transform)));
 
-            return t.transformRect(body.getBounds());
+            if (body.getPrimitiveType() == sf::TriangleFan) {
+                batch.append_fan(VertexBatch::State(), &body[0], body.getVertexCount(), transform * body_transform);
+            } else {
+                batch.append_strip(VertexBatch::State(), &body[0], body.getVertexCount(), transform * body_transform);
+            }
         }
 
     protected:
         void draw(sf::RenderTarget &target, sf::RenderStates states) const override {
             // arrow should always track targets
-            sf::VertexArray body;
-            sf::Transform t;
-            construct_body(body, t);
+            update_body_at_scale(LevelOfDetail::quantize(LevelOfDetail::pixels_per_unit(target, states.transform)));
 
-            states.transform = states.transform * t;
+            states.transform = states.transform * body_transform;
 
             target.draw(body, states);
         }
 
     private:
-        void construct_body(sf::VertexArray& body, sf::Transform& t) const {
-            auto head_target_xy = head_target.lock()->local_to_world_transform().transformPoint(0, 0);
-            auto tail_target_xy = tail_target.lock()->local_to_world_transform().transformPoint(0, 0);
+        /**
+         * Rebuilds the body for the screen scale it is drawn at. Adding or dropping the head changes the bounds
+         * without any target moving, so that is reported as a bounds change.
+         */
+        void update_body_at_scale(const float& new_screen_scale) const {
+            bool rescaled = body_key.has_value() && new_screen_scale != screen_scale;
+            auto bounds_before = body_bounds;
+
+            screen_scale = new_screen_scale;
+            update_body();
+
+            if (rescaled && body_bounds != bounds_before) {
+                bounds_changed();
+            }
+        }
+
+        /**
+         * Rebuilds the cached body if either target, the parent, the build percent, the color, the head flag or the
+         * screen scale changed since it was last built. Versions are read after the world transforms are queried, so any later
+         * change to them is seen as a new version.
+         */
+        void update_body() const {
+            auto head = head_target.lock();
+            auto tail = tail_target.lock();
+            auto p = parent.lock();
+
+            BodyKey key {
+                    head->world_transform_version(),
+                    tail->world_transform_version(),
+                    p->world_transform_version(),
+                    build_percent,
+                    _fill_color,
+                    _draw_head,
+                    screen_scale
+            };
+
+            if (body_key == key) {
+                return;
+            }
 
-            head_target_xy = parent.lock()->world_to_local_transform().transformPoint(head_target_xy);
-            tail_target_xy = parent.lock()->world_to_local_transform().transformPoint(tail_target_xy);
+            auto head_target_xy = p->world_to_local_transform().transformPoint(
+                    head->local_to_world_transform().transformPoint(0, 0));
+            auto tail_target_xy = p->world_to_local_transform().transformPoint(
+                    tail->local_to_world_transform().transformPoint(0, 0));
 
+            construct_body(tail_target_xy, head_target_xy);
+            body_bounds = body_transform.transformRect(body.getBounds());
+
+            key.head_version = head->world_transform_version();
+            key.tail_version = tail->world_transform_version();
+            key.parent_version = p->world_transform_version();
+            body_key = key;
+            body_revision++;
+        }
+
+        /**
+         * fills body and body_transform for an arrow between the specified points in parent local coordinates. The
+         * vertex array is resized in place, so rebuilding does not allocate once the arrow has been drawn. The head
+         * is left out while the arrow is shorter than LevelOfDetail::arrow_head_min_pixels on screen.
+         */
+        void construct_body(const sf::Vector2f& tail_target_xy, const sf::Vector2f& head_target_xy) const {
             float x0 = tail_target_xy.x;
             float y0 = tail_target_xy.y;
 
@@ -101,8 +214,12 @@ namespace atk {
             auto head_half_thickness = 0.5f * head_thickness.get_adjusted(length);
             auto undercut = head_undercut.get_adjusted(length);
 
-            if (_draw_head) {
-                body = sf::VertexArray(sf::TriangleFan, 7);
+            bool head_visible = _draw_head
+                    && length * build_percent * screen_scale >= LevelOfDetail::arrow_head_min_pixels;
+
+            if (head_visible) {
+                body.setPrimitiveType(sf::TriangleFan);
+                body.resize(7);
                 body[0] = sf::Vertex(sf::Vector2f(head_l_end, 0), _fill_color);
                 body[1] = sf::Vertex(sf::Vector2f(head_l_start, -half_line_thickness - head_half_thickness), _fill_color);
                 body[2] = sf::Vertex(sf::Vector2f(head_l_start + undercut, -half_line_thickness), _fill_color);
@@ -111,7 +228,8 @@ namespace atk {
                 body[5] = sf::Vertex(sf::Vector2f(head_l_start + undercut, half_line_thickness), _fill_color);
                 body[6] = sf::Vertex(sf::Vector2f(head_l_start, half_line_thickness + head_half_thickness), _fill_color);
             } else {
-                body = sf::VertexArray(sf::TriangleStrip, 4);
+                body.setPrimitiveType(sf::TriangleStrip);
+                body.resize(4);
                 body[0] = sf::Vertex(sf::Vector2f(tail_l_start, -half_line_thickness), _fill_color);
                 body[1] = sf::Vertex(sf::Vector2f(tail_l_start, half_line_thickness), _fill_color);
                 body[2] = sf::Vertex(sf::Vector2f(head_l_end, -half_line_thickness), _fill_color);
@@ -120,10 +238,10 @@ namespace atk {
 
             float angle = std::atan2(y1 - y0, x1 - x0);
             float angle_deg = 180.0f * angle * (float)M_1_PI;
-            t = sf::Transform::Identity;
-            t.translate(x0, y0);
-            t.rotate(angle_deg);
-            t.scale(build_percent, build_percent);
+            body_transform = sf::Transform::Identity;
+            body_transform.translate(x0, y0);
+            body_transform.rotate(angle_deg);
+            body_transform.scale(build_percent, build_percent);
         }
     };
 }
@@ -0,0 +1,21 @@
+#ifndef ENTITIES_BATCHABLE_H
+#define ENTITIES_BATCHABLE_H
+
+#include <SFML/Graphics.hpp>
+
+#include "../rendering/vertex_batch.h"
+
+namespace atk {
+
+    /**
+     * Indicates that a drawable can submit its geometry to a shared VertexBatch instead of being drawn on its own.
+     * The result must look the same as drawing the element with the specified transform.
+     */
+    class Batchable {
+    public:
+        virtual void batch(VertexBatch& batch, const sf::Transform& transform) const = 0;
+    };
+
+}
+
+#endif
@@ -2,16 +2,19 @@
 #define ENTITIES_CURVE_H
 
 #include "buildable.h"
+#include "batchable.h"
 #include "../constants.h"
 #include "../utils/bounds.h"
+#include "../utils/color.h"
 #include "shader_cache.h"
+#include "../rendering/level_of_detail.h"
 
 namespace atk {
 
     /**
      * Arbitrary curve sampled along some interval.
      */
-    class Curve: public sf::Drawable, public Buildable, public LocalBoundable {
+    class Curve: public sf::Drawable, public Buildable, public LocalBoundable, public Batchable {
     private:
         static constexpr const char* VERTEX_SHADER_SRC = R"VERTEX_SHADER(
                                 void main()
@@ -50,7 +53,7 @@ namespace atk {
                                     gl_FragColor = vec4(gl_Color.x, gl_Color.y, gl_Color.z, opacity); //gl_Color * pixel;
                                 })FRAGMENT_SHADER";
 
-        std::weak_ptr<ShaderCache> shader_cache;
+        ShaderCache::Handle program;
 
         float u0;
         float u1;
@@ -65,18 +68,59 @@ namespace atk {
 
         std::function<sf::Color(float)> color_sample;
 
-        std::vector<sf::Vertex> verts;
+        /**
+         * when set, samples are placed adaptively so the polyline stays within this many pixels of the curve at the
+         * screen scale it was last drawn at, instead of using sample_count evenly spaced samples.
+         */
+        std::optional<float> flatness_tolerance;
+
+        /**
+         * pixels per local unit, rounded to a power of two, that the current tessellation was made for
+         */
+        mutable float tessellation_scale = 1.0f;
+
+        /**
+         * length of the curve sampled at sample_count, measured when first needed to pick a lower sample count for
+         * small on screen sizes
+         */
+        mutable std::optional<float> curve_length;
+
+        static constexpr int MIN_UNIFORM_SAMPLES = 2;
+
+        static constexpr int MAX_ADAPTIVE_DEPTH = 10;
+
+        /**
+         * triangle strip of the whole curve, sampled once per change of the sample functions, thickness or (when
+         * adaptive) screen scale. Vertices come in pairs straddling the centre line; arc_lengths holds the centre line
+         * length up to each pair.
+         */
+        mutable std::vector<sf::Vertex> full_verts;
+        mutable std::vector<float> arc_lengths;
+
+        /**
+         * the visible prefix of full_verts for the current build percent, ending on an interpolated pair.
+         */
+        mutable std::vector<sf::Vertex> verts;
+
+        mutable sf::FloatRect bounds;
 
     public:
         Curve(Curve &&to_move) noexcept :
                 u0(to_move.u0),
                 u1(to_move.u1),
-                shader_cache(std::move(to_move.shader_cache)),
+                program(std::move(to_move.program)),
                 sample(std::move(to_move.sample)),
                 sample_count(to_move.sample_count),
                 color_sample(to_move.color_sample) {
 
+            flatness_tolerance = to_move.flatness_tolerance;
+            tessellation_scale = to_move.tessellation_scale;
+            curve_length = to_move.curve_length;
+            sample_us = std::move(to_move.sample_us);
+            full_verts = std::move(to_move.full_verts);
+            arc_lengths = std::move(to_move.arc_lengths);
             verts = std::move(to_move.verts);
+            bounds = to_move.bounds;
             sample_points = std::move(to_move.sample_points);
         }
 
@@ -91,25 +135,18 @@ namespace atk {
                 sample(std::move(sample)),
                 sample_count(sample_count),
                 color_sample(std::move(color_sample)),
-                shader_cache(shader_cache){
+                program(shader_cache->load(VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC)) {
 
-            resample();
+            tessellate();
         }
 
         sf::FloatRect get_local_bounds() override {
-            resample();
-            sf::FloatRect bounds(verts[0].position.x, verts[0].position.y, 0, 0);
-
-            for (auto &v : verts) {
-                auto v_bounds = sf::FloatRect(v.position.x, v.position.y, 0, 0);
-                bounds = BoundsUtil::combine(bounds, v_bounds);
-            }
-
             return bounds;
         }
 
         void set_thickness(const float& thickness) {
             half_thickness = thickness / 2;
+            tessellate();
         }
 
         float get_thickness() const {
@@ -118,7 +155,17 @@ namespace atk {
 
         void change_sample(std::function<std::pair<float, float>(float)> sample) {
             this->sample = std::move(sample);
-            resample();
+            curve_length = std::nullopt;
+            tessellate();
+        }
+
+        /**
+         * Switches to adaptive sampling with the specified maximum deviation in pixels, or back to sample_count evenly
+         * spaced samples if nullopt.
+         */
+        void set_flatness_tolerance(const std::optional<float>& tolerance_pixels) {
+            flatness_tolerance = tolerance_pixels;
+            tessellate();
         }
 
         [[nodiscard]] const std::vector<sf::Vertex>& get_verts() const {
@@ -131,19 +178,28 @@ namespace atk {
 
         void set_build_percent(const float &new_build_percent) override {
             this->build_percent = new_build_percent;
-            resample();
+            truncate();
+        }
+
+        void batch(VertexBatch &batch, const sf::Transform &transform) const override {
+            update_screen_scale(batch.view_scale() * TransformUtils::get_scale_factor(transform));
+            batch.append_strip(batch_state(), verts.data(), verts.size(), transform);
         }
 
     public:
         void draw(sf::RenderTarget &target, sf::RenderStates states) const override {
             sf::RenderStates states_with_shader(states);
 
-            auto shader = shader_cache.lock()->get_shader(VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC);
+            auto state = batch_state();
+            state.program->apply(state.apply, state.uniforms);
 
-            shader->setUniform("buffer_percent", 0.4f);
-            
-            states_with_shader.shader = shader.get();
+            states_with_shader.shader = &state.program->shader();
 
+            update_screen_scale(LevelOfDetail::pixels_per_unit(target, states.transform));
+
+            if (verts.empty()) {
+                return;
+            }
 
             target.draw(&verts[0], verts.size(), sf::TriangleStrip, states_with_shader);
             return;
@@ -176,58 +232,173 @@ namespace atk {
 
     private:
 
-        std::vector<sf::Vector2f> sample_points;
-        void resample() {
-            sample_points.clear();
-            verts.clear();
+        VertexBatch::State batch_state() const {
+            return VertexBatch::State { program.get(), &apply_uniforms, { 0.4f } };
+        }
 
-            auto build_percent_adjusted_u1 = u0 + (u1 - u0) * build_percent;
+        static void apply_uniforms(sf::Shader& shader, const VertexBatch::Uniforms& uniforms) {
+            shader.setUniform("buffer_percent", uniforms[0]);
+        }
 
+        mutable std::vector<float> sample_us;
+        mutable std::vector<sf::Vector2f> sample_points;
+        mutable sf::Vector2f last_centre;
+
+        /**
+         * Resamples the curve if the screen scale moved to a different power of two since it was last tessellated.
+         * Adaptive sampling places its samples for the new scale; even sampling may use fewer samples than
+         * sample_count once they would be closer than LevelOfDetail::curve_sample_spacing_pixels on screen.
+         */
+        void update_screen_scale(const float& pixels_per_unit) const {
+            if (!std::isfinite(pixels_per_unit) || pixels_per_unit <= 0) {
+                return;
+            }
 
-            auto u_inc = (build_percent_adjusted_u1 - u0) / (float)sample_count;
-            sample_points.clear();
+            auto quantized = LevelOfDetail::quantize(pixels_per_unit);
+            if (quantized != tessellation_scale) {
+                tessellation_scale = quantized;
+                if (flatness_tolerance || uniform_sample_count() != (int)sample_us.size() - 1) {
+                    tessellate();
+                }
+            }
+        }
 
-            // first / last sample points, rotate vector to get normal
+        /**
+         * @return the number of evenly spaced intervals to sample at the current tessellation scale, at most sample_count
+         */
+        int uniform_sample_count() const {
+            if (!curve_length) {
+                float length = 0;
+                auto prev = sample(u0);
+                auto u_inc = (u1 - u0) / (float)sample_count;
+                for (int i = 1; i <= sample_count; i++) {
+                    auto s = sample(u0 + (float)i * u_inc);
+                    length += std::hypot(s.first - prev.first, s.second - prev.second);
+                    prev = s;
+                }
+                curve_length = length;
+            }
+
+            auto needed = (int)std::ceil(*curve_length * tessellation_scale / LevelOfDetail::curve_sample_spacing_pixels);
+            return std::clamp(needed, std::min(MIN_UNIFORM_SAMPLES, sample_count), sample_count);
+        }
 
+        /**
+         * fills sample_us and sample_points with uniform_sample_count() + 1 evenly spaced samples
+         */
+        void sample_uniform() const {
+            auto count = uniform_sample_count();
+            auto u_inc = (u1 - u0) / (float)count;
+            for (int i = 0; i <= count; i++) {
+                float u = u0 + (float)i * u_inc;
+                auto s = sample(u);
+                sample_us.push_back(u);
+                sample_points.emplace_back(s.first, s.second);
+            }
+        }
+
+        /**
+         * fills sample_us and sample_points with just enough samples that the polyline through them stays within the
+         * tolerance of the curve, as far as the subdivision test can see.
+         */
+        void sample_adaptive(const float& tolerance) const {
             auto s0 = sample(u0);
+            auto s1 = sample(u1);
+            float um = 0.5f * (u0 + u1);
+            auto sm = sample(um);
+
+            sample_us.push_back(u0);
             sample_points.emplace_back(s0.first, s0.second);
-            auto s1 = sample(u0 + u_inc);
-            sample_points.emplace_back(s1.first, s1.second);
+            subdivide(u0, sf::Vector2f(s0.first, s0.second),
+                      u1, sf::Vector2f(s1.first, s1.second),
+                      um, sf::Vector2f(sm.first, sm.second),
+                      tolerance, 0);
+        }
 
-            auto delta = sub(sample_points[1], sample_points[0]);
-            sf::Vector2f offset;
-            sf::Color color;
-            if (delta.x != 0 || delta.y != 0) {
-                offset = scale(rotate(normalize(delta), M_PI_2), half_thickness);
+        /**
+         * Appends samples for (ua, ub]. The interval is flat enough when its midpoint and quarter points all lie within
+         * the tolerance of the chord; otherwise each half is subdivided, reusing the quarter points as their midpoints.
+         */
+        void subdivide(const float& ua, const sf::Vector2f& pa,
+                       const float& ub, const sf::Vector2f& pb,
+                       const float& um, const sf::Vector2f& pm,
+                       const float& tolerance, const int& depth) const {
+            float uq1 = 0.5f * (ua + um);
+            float uq3 = 0.5f * (um + ub);
+            auto sq1 = sample(uq1);
+            auto sq3 = sample(uq3);
+            sf::Vector2f pq1(sq1.first, sq1.second);
+            sf::Vector2f pq3(sq3.first, sq3.second);
+
+            bool flat = distance_to_chord(pm, pa, pb) <= tolerance
+                        && distance_to_chord(pq1, pa, pb) <= tolerance
+                        && distance_to_chord(pq3, pa, pb) <= tolerance;
+
+            if (flat || depth >= MAX_ADAPTIVE_DEPTH) {
+                sample_us.push_back(ub);
+                sample_points.push_back(pb);
+                return;
+            }
 
-                color = color_sample(u0);
+            subdivide(ua, pa, um, pm, uq1, pq1, tolerance, depth + 1);
+            subdivide(um, pm, ub, pb, uq3, pq3, tolerance, depth + 1);
+        }
+
+        static float distance_to_chord(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+            auto chord = sub(b, a);
+            auto to_p = sub(p, a);
+            auto chord_length = std::sqrt(chord.x * chord.x + chord.y * chord.y);
 
-                verts.emplace_back(sf::Vector2f(sf::Vector2f(s0.first, s0.second) - offset),
-                                   color,
-                                   sf::Vector2f(0, 0));
-                verts.emplace_back(sf::Vector2f(sf::Vector2f(s0.first, s0.second) + offset),
-                                   color,
-                                   sf::Vector2f(0, 1));
+            if (chord_length == 0) {
+                return std::sqrt(to_p.x * to_p.x + to_p.y * to_p.y);
             }
 
-            for (int i = 2; i <= sample_count; i++) {
-                float u = u0 + (float)i * u_inc;
-                auto sample_point = sample(u);
+            return std::abs(chord.x * to_p.y - chord.y * to_p.x) / chord_length;
+        }
+
+        /**
+         * Samples the whole curve, rebuilding full_verts and arc_lengths, then truncates it to the build percent.
+         */
+        void tessellate() const {
+            sample_us.clear();
+            sample_points.clear();
+            full_verts.clear();
+            arc_lengths.clear();
+
+            if (flatness_tolerance) {
+                sample_adaptive(*flatness_tolerance / tessellation_scale);
+            } else {
+                sample_uniform();
+            }
 
-                sample_points.emplace_back(sample_point.first, sample_point.second);
+            auto n = sample_points.size();
+
+            // first / last sample points, rotate vector to get normal
 
-                sf::Vector2f xy_next = sample_points.back();
-                sf::Vector2f xy = sample_points[i - 1];
-                sf::Vector2f xy_prev = sample_points[i-2];
+            auto delta = sub(sample_points[1], sample_points[0]);
+            sf::Vector2f offset;
+            sf::Color color;
+            if (delta.x != 0 || delta.y != 0) {
+                offset = scale(perpendicular(normalize(delta)), half_thickness);
 
-                sf::Vector2f to_prev = sub(xy_prev, xy);
-                sf::Vector2f to_next = sub(xy_next, xy);
+                color = color_sample(sample_us[0]);
 
-                //std::cout << "    to-prev: " << to_prev.x << ", " << to_prev.y << std::endl;
-                //std::cout << "    to-next: " << to_next.x << ", " << to_next.y << std::endl;
+                full_verts.emplace_back(sample_points[0] - offset,
+                                        color,
+                                        sf::Vector2f(0, 0));
+                full_verts.emplace_back(sample_points[0] + offset,
+                                        color,
+                                        sf::Vector2f(0, 1));
+                push_arc_length(sample_points[0]);
+            }
 
-                to_prev = rotate(to_prev, M_PI_2);
-                to_next = rotate(to_next, -M_PI_2);
+            for (std::size_t i = 1; i + 1 < n; i++) {
+                sf::Vector2f xy_next = sample_points[i + 1];
+                sf::Vector2f xy = sample_points[i];
+                sf::Vector2f xy_prev = sample_points[i - 1];
+
+                sf::Vector2f to_prev = perpendicular(sub(xy_prev, xy));
+                sf::Vector2f to_next = -perpendicular(sub(xy_next, xy));
 
                 sf::Vector2f norm = add(to_prev, to_next);
 
@@ -239,36 +410,91 @@ namespace atk {
                 sf::Vector2f offset = scale(norm, half_thickness);
 
                 // build the triangle strip from this
-                auto color = color_sample(u);
-                verts.emplace_back(
+                auto color = color_sample(sample_us[i]);
+                full_verts.emplace_back(
                         xy + offset,
                         color,
                         sf::Vector2f(0, 0));
-                verts.emplace_back(
+                full_verts.emplace_back(
                         xy - offset,
                         color,
                         sf::Vector2f(0, 1));
+                push_arc_length(xy);
             }
 
-            delta = sub(sample_points.back(), sample_points[sample_points.size() - 2]);
+            delta = sub(sample_points[n - 1], sample_points[n - 2]);
             if (delta.x != 0 || delta.y != 0) {
 
-                offset = scale(rotate(normalize(delta), M_PI_2), half_thickness);
-                color = color_sample(u1);
-                verts.emplace_back(sample_points.back() - offset, color, sf::Vector2f(0, 0));
-                verts.emplace_back(sample_points.back() + offset, color, sf::Vector2f(0, 1));
+                offset = scale(perpendicular(normalize(delta)), half_thickness);
+                color = color_sample(sample_us[n - 1]);
+                full_verts.emplace_back(sample_points[n - 1] - offset, color, sf::Vector2f(0, 0));
+                full_verts.emplace_back(sample_points[n - 1] + offset, color, sf::Vector2f(0, 1));
+                push_arc_length(sample_points[n - 1]);
             }
 
+            truncate();
         }
 
-        sf::Vector2f scale(const sf::Vector2f& input, const float& scale) {
+        /**
+         * records the centre line length up to a new pair of full_verts centred on the specified point.
+         */
+        void push_arc_length(const sf::Vector2f& centre) const {
+            if (arc_lengths.empty()) {
+                arc_lengths.push_back(0);
+            } else {
+                auto d = sub(centre, last_centre);
+                arc_lengths.push_back(arc_lengths.back() + std::sqrt(d.x * d.x + d.y * d.y));
+            }
+            last_centre = centre;
+        }
+
+        /**
+         * Copies the prefix of full_verts covering build_percent of the arc length into verts, ending on a pair
+         * interpolated between the two cached pairs that straddle the cut, and updates the bounds to match.
+         */
+        void truncate() const {
+            verts.clear();
+
+            if (full_verts.empty() || build_percent <= 0) {
+                bounds = sf::FloatRect();
+                bounds_changed();
+                return;
+            }
+
+            auto length = arc_lengths.back() * std::min(build_percent, 1.0f);
+            auto end = std::lower_bound(arc_lengths.begin(), arc_lengths.end(), length) - arc_lengths.begin();
+
+            if (end == 0 || arc_lengths[end] == length) {
+                verts.assign(full_verts.begin(), full_verts.begin() + 2 * (end + 1));
+            } else {
+                verts.assign(full_verts.begin(), full_verts.begin() + 2 * end);
+
+                auto frac = (length - arc_lengths[end - 1]) / (arc_lengths[end] - arc_lengths[end - 1]);
+                for (int side = 0; side < 2; side++) {
+                    const auto& a = full_verts[2 * (end - 1) + side];
+                    const auto& b = full_verts[2 * end + side];
+                    verts.emplace_back(a.position + frac * (b.position - a.position),
+                                       ColorUtils::lerp(frac, a.color, b.color),
+                                       b.texCoords);
+                }
+            }
+
+            bounds = sf::FloatRect(verts[0].position.x, verts[0].position.y, 0, 0);
+            for (auto &v : verts) {
+                auto v_bounds = sf::FloatRect(v.position.x, v.position.y, 0, 0);
+                bounds = BoundsUtil::combine(bounds, v_bounds);
+            }
+            bounds_changed();
+        }
+
+        static sf::Vector2f scale(const sf::Vector2f& input, const float& scale) {
             return sf::Vector2f(
                     input.x * scale,
                     input.y * scale
             );
         }
 
-        sf::Vector2f sub(const sf::Vector2f& a, const sf::Vector2f& b) {
+        static sf::Vector2f sub(const sf::Vector2f& a, const sf::Vector2f& b) {
             return sf::Vector2f(
                     a.x - b.x,
                     a.y - b.y
@@ -276,14 +502,14 @@ namespace atk {
         }
 
 
-        sf::Vector2f add(const sf::Vector2f& a, const sf::Vector2f& b) {
+        static sf::Vector2f add(const sf::Vector2f& a, const sf::Vector2f& b) {
             return sf::Vector2f(
                     a.x + b.x,
                     a.y + b.y
             );
         }
 
-        sf::Vector2f normalize(const sf::Vector2f& input) {
+        static sf::Vector2f normalize(const sf::Vector2f& input) {
             if (input.x == 0 && input.y == 0) {
                 throw std::runtime_error("Vector has zero length");
             }
@@ -294,13 +520,11 @@ namespace atk {
             return sf::Vector2f(input.x / mag, input.y / mag);
         }
 
-        sf::Vector2f rotate(const sf::Vector2f& input, const float& angle) {
-            auto cos = std::cos(angle);
-            auto sin = std::sin(angle);
-
-            return sf::Vector2f(
-                    cos * input.x - sin * input.y,
-                    sin * input.x + cos * input.y);
+        /**
+         * input rotated by a quarter turn counterclockwise
+         */
+        static sf::Vector2f perpendicular(const sf::Vector2f& input) {
+            return sf::Vector2f(-input.y, input.x);
         }
 
 
@@ -9,6 +9,12 @@
 namespace atk {
 
     class Grid {
+    private:
+        /**
+         * grid lines are straight, so adaptive sampling reduces each to a single segment
+         */
+        static constexpr float GRID_FLATNESS_TOLERANCE = 0.5f;
+
     public:
         static std::shared_ptr<SceneNode> build(
                 std::shared_ptr<ShaderCache> shader_cache,
@@ -26,24 +32,26 @@ namespace atk {
                 std::stringstream ss;
                 ss << i;
                 float y = y_increment * (float)i;
-                h_lines->add(ss.str(),
-                        std::make_unique<Curve>(
+                auto line = std::make_unique<Curve>(
                         0, width,
                         shader_cache,
                         [y](float u){ return std::make_pair(u, y); },
-                        10));
+                        10);
+                line->set_flatness_tolerance(GRID_FLATNESS_TOLERANCE);
+                h_lines->add(ss.str(), std::move(line));
             }
 
             for (int i = 0; i <= x_count; i++) {
                 std::stringstream ss;
                 ss << i;
                 float x = x_increment * (float)i;
-                v_lines->add(ss.str(),
-                        std::make_unique<Curve>(
+                auto line = std::make_unique<Curve>(
                         0, height,
                         shader_cache,
                         [x](float u){ return std::make_pair(x, u); },
-                        10));
+                        10);
+                line->set_flatness_tolerance(GRID_FLATNESS_TOLERANCE);
+                v_lines->add(ss.str(), std::move(line));
             }
 
             return result;
@@ -3,13 +3,72 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <cstdint>
+
 namespace atk {
 
+    /**
+     * Notified when the local bounds or the appearance of a LocalBoundable it observes may have changed.
+     */
+    class BoundsObserver {
+    public:
+        virtual ~BoundsObserver() = default;
+
+        virtual void local_bounds_changed() = 0;
+
+        virtual void local_appearance_changed() {}
+    };
+
     class LocalBoundable {
+    private:
+        BoundsObserver* bounds_observer = nullptr;
+
     public:
+        virtual ~LocalBoundable() = default;
+
         virtual sf::FloatRect get_local_bounds() = 0;
+
+        /**
+         * @return true if the local bounds can change without bounds_changed being called, for example because they
+         * follow other nodes of the scene. Bounds of such drawables are rechecked whenever bounds_version changes.
+         */
+        [[nodiscard]] virtual bool has_external_bounds_dependencies() const {
+            return false;
+        }
+
+        /**
+         * @return a value that changes whenever the local bounds may have changed without bounds_changed being
+         * called. Only queried if has_external_bounds_dependencies.
+         */
+        [[nodiscard]] virtual std::uint64_t bounds_version() const {
+            return 0;
+        }
+
+        void set_bounds_observer(BoundsObserver* observer) {
+            bounds_observer = observer;
+        }
+
+    protected:
+        /**
+         * to be called by implementations whenever the value returned by get_local_bounds may have changed
+         */
+        void bounds_changed() const {
+            if (bounds_observer != nullptr) {
+                bounds_observer->local_bounds_changed();
+            }
+        }
+
+        /**
+         * to be called by implementations whenever they would be drawn differently within the same bounds, for
+         * example after a color change
+         */
+        void appearance_changed() const {
+            if (bounds_observer != nullptr) {
+                bounds_observer->local_appearance_changed();
+            }
+        }
     };
 
 }
 
-#endif
\ No newline at end of file
+#endif
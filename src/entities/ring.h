@@ -4,15 +4,100 @@
 #include <SFML/Graphics.hpp>
 
 #include "buildable.h"
+#include "batchable.h"
 #include "local_boundable.h"
+#include "sdf_disc.h"
 #include "../constants.h"
 
 namespace atk {
-    class Ring : public sf::Drawable, public Buildable, public LocalBoundable {
 
+    /**
+     * Annulus of a given outer radius and band thickness. Grows from its center while being built.
+     */
+    class Ring : public sf::Drawable, public Buildable, public LocalBoundable, public Batchable {
+    private:
+        float percent_complete = 1.0f;
 
+        float radius;
+        float thickness;
 
+        /**
+         * unit quad in the fill color. Radius and build percent are applied as a scale when drawing.
+         */
+        sf::VertexArray shape;
+
+        sf::Color _fill_color;
+        sf::Color _outline_color = atk::constants::color::SolarizedDark::green;
+
+        float outline_percent = 0.0f;
+
+        ShaderCache::Handle program;
+
+    public:
+        Ring(const float& radius,
+             const float& thickness,
+             const std::shared_ptr<ShaderCache>& shader_cache,
+             const sf::Color fill_color = atk::constants::color::SolarizedDark::magenta) :
+                radius(radius),
+                thickness(thickness),
+                _fill_color(fill_color),
+                program(SdfDisc::load(*shader_cache)) {
+            if (thickness <= 0 || thickness > radius) {
+                throw std::runtime_error("Ring thickness must be positive and no larger than its radius");
+            }
+
+            SdfDisc::build_quad(shape, _fill_color);
+        }
+
+        void set_fill_color(const sf::Color& new_color) {
+            _fill_color = new_color;
+            SdfDisc::set_color(shape, _fill_color);
+            appearance_changed();
+        }
+
+        /**
+         * outline drawn along both edges of the band, as a fraction of half the band thickness
+         */
+        void set_outline(const sf::Color& outline_color, const float& new_outline_percent) {
+            _outline_color = outline_color;
+            outline_percent = new_outline_percent;
+            appearance_changed();
+        }
+
+        float get_build_percent() override {
+            return percent_complete;
+        }
+
+        void set_build_percent(const float &build_percent) override {
+            percent_complete = build_percent;
+            bounds_changed();
+        }
+
+        sf::FloatRect get_local_bounds() override {
+            float actual_radius = radius * percent_complete;
+
+            return sf::FloatRect(
+                    -actual_radius,
+                    -actual_radius,
+                    2.0f * actual_radius,
+                    2.0f * actual_radius);
+        }
+
+        void batch(VertexBatch &batch, const sf::Transform &transform) const override {
+            SdfDisc::batch(batch, transform, shape, radius * percent_complete, batch_state());
+        }
+
+    protected:
+        void draw(sf::RenderTarget &target, sf::RenderStates states) const override {
+            SdfDisc::draw(target, states, shape, radius * percent_complete, batch_state());
+        }
+
+    private:
+        VertexBatch::State batch_state() const {
+            return SdfDisc::batch_state(*program, _outline_color, outline_percent,
+                                        (radius - thickness) / radius);
+        }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
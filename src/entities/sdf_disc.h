@@ -0,0 +1,137 @@
+#ifndef ENTITIES_SDF_DISC_H
+#define ENTITIES_SDF_DISC_H
+
+#include "shader_cache.h"
+#include "../rendering/vertex_batch.h"
+
+namespace atk {
+
+    /**
+     * Shader and geometry shared by the circular primitives. Each primitive is a single quad covering the unit
+     * circle; the fragment shader cuts the disc, ring band and outline out of it from the distance to the centre.
+     * Position, radius and build percent live in the transform and the fill color in the vertices, so primitives
+     * sharing an outline style land in one VertexBatch group and draw in a single call.
+     */
+    class SdfDisc {
+    private:
+        static constexpr const char* VERTEX_SHADER_SRC = R"VERTEX_SHADER(
+                                void main()
+                                {
+                                    // transform the vertex position
+                                    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+
+                                    // transform the texture coordinates
+                                    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+
+                                    // forward the vertex color
+                                    gl_FrontColor = gl_Color;
+                                })VERTEX_SHADER";
+
+        static constexpr const char* FRAGMENT_SHADER_SRC = R"FRAGMENT_SHADER(
+                                uniform float buffer_percent;
+                                uniform vec4 outline_color;
+                                uniform float outline_percent;
+                                uniform float inner_percent;
+
+                                void main()
+                                {
+                                    // texture coordinates run from -1 to 1 across the quad
+                                    float d = length(gl_TexCoord[0].xy);
+
+                                    if (d > 1.0 || d < inner_percent) {
+                                        discard;
+                                    }
+
+                                    // 1 at the centre of a disc or the middle of a ring band, 0 at its edges
+                                    float dist_to_edge = 1.0 - d;
+                                    if (inner_percent > 0.0) {
+                                        dist_to_edge = min(1.0 - d, d - inner_percent) / (0.5 * (1.0 - inner_percent));
+                                    }
+
+                                    vec4 core_color = (dist_to_edge > outline_percent) ? gl_Color : outline_color;
+
+                                    float opacity = 1.0;
+                                    if (dist_to_edge <= buffer_percent) {
+                                        opacity = dist_to_edge / buffer_percent;
+                                    }
+
+                                    gl_FragColor = vec4(core_color.x, core_color.y, core_color.z, opacity);
+                                })FRAGMENT_SHADER";
+
+    public:
+        static constexpr float BUFFER_PERCENT = 0.1f;
+
+        /**
+         * fills quad with a unit square triangle fan in the specified color
+         */
+        static void build_quad(sf::VertexArray& quad, const sf::Color& fill_color) {
+            quad = sf::VertexArray(sf::TriangleFan, 4);
+            quad[0] = sf::Vertex(sf::Vector2f(-1, -1), fill_color, sf::Vector2f(-1, -1));
+            quad[1] = sf::Vertex(sf::Vector2f(1, -1), fill_color, sf::Vector2f(1, -1));
+            quad[2] = sf::Vertex(sf::Vector2f(1, 1), fill_color, sf::Vector2f(1, 1));
+            quad[3] = sf::Vertex(sf::Vector2f(-1, 1), fill_color, sf::Vector2f(-1, 1));
+        }
+
+        static void set_color(sf::VertexArray& quad, const sf::Color& fill_color) {
+            for (std::size_t i = 0; i < quad.getVertexCount(); i++) {
+                quad[i].color = fill_color;
+            }
+        }
+
+        static ShaderCache::Handle load(ShaderCache& shader_cache) {
+            return shader_cache.load(VERTEX_SHADER_SRC, FRAGMENT_SHADER_SRC);
+        }
+
+        /**
+         * @param program handle returned by load
+         * @param inner_percent inner radius of a ring as a fraction of its outer radius, 0 for a disc
+         */
+        static VertexBatch::State batch_state(ShaderProgram& program,
+                                              const sf::Color& outline_color,
+                                              const float& outline_percent,
+                                              const float& inner_percent) {
+            return VertexBatch::State {
+                    &program,
+                    &apply_uniforms,
+                    { BUFFER_PERCENT,
+                      (float)outline_color.r / 255.0f,
+                      (float)outline_color.g / 255.0f,
+                      (float)outline_color.b / 255.0f,
+                      (float)outline_color.a / 255.0f,
+                      outline_percent,
+                      inner_percent }};
+        }
+
+        /**
+         * draws a quad built by build_quad scaled to the specified radius
+         */
+        static void draw(sf::RenderTarget& target, sf::RenderStates states, const sf::VertexArray& quad,
+                         const float& radius, const VertexBatch::State& state) {
+            state.program->apply(state.apply, state.uniforms);
+            states.shader = &state.program->shader();
+            states.transform = states.transform * scale_transform(radius);
+            target.draw(quad, states);
+        }
+
+        static void batch(VertexBatch& batch, const sf::Transform& transform, const sf::VertexArray& quad,
+                          const float& radius, const VertexBatch::State& state) {
+            batch.append_fan(state, &quad[0], quad.getVertexCount(), transform * scale_transform(radius));
+        }
+
+    private:
+        static sf::Transform scale_transform(const float& radius) {
+            sf::Transform t;
+            t.scale(radius, radius);
+            return t;
+        }
+
+        static void apply_uniforms(sf::Shader& shader, const VertexBatch::Uniforms& uniforms) {
+            shader.setUniform("buffer_percent", uniforms[0]);
+            shader.setUniform("outline_color", sf::Glsl::Vec4(uniforms[1], uniforms[2], uniforms[3], uniforms[4]));
+            shader.setUniform("outline_percent", uniforms[5]);
+            shader.setUniform("inner_percent", uniforms[6]);
+        }
+    };
+}
+
+#endif
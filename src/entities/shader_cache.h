@@ -2,41 +2,93 @@
 #define ENTITIES_SHADER_CACHE_H
 
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <map>
 #include <memory>
 
 namespace atk {
 
     /**
-     *  Manages access to loaded shaders
+     * A loaded shader together with the uniform values last uploaded to it. Uploads go through apply, which skips
+     * them when the same values were the last ones set, so consecutive draws sharing uniforms cost no GL calls.
      */
-    class ShaderCache {
-        using CacheEntry = std::pair<std::string, std::string>;
+    class ShaderProgram {
+    public:
+        using Uniforms = std::array<float, 8>;
+        using ApplyUniforms = void (*)(sf::Shader&, const Uniforms&);
 
     private:
-        std::map<CacheEntry, std::shared_ptr<sf::Shader>> shaders;
+        sf::Shader _shader;
+
+        ApplyUniforms last_apply = nullptr;
+        Uniforms last_uniforms {};
 
     public:
-        std::shared_ptr<sf::Shader> get_shader(const std::string &vertex, const std::string &fragment) {
-            CacheEntry cache_entry = std::make_pair(vertex, fragment);
+        ShaderProgram(const std::string &vertex, const std::string &fragment) {
+            if (!_shader.loadFromMemory(vertex, sf::Shader::Vertex)) {
+                throw std::runtime_error("Could not load vertex shader.");
+            }
 
-            if (shaders.contains(cache_entry)) {
-                return shaders[cache_entry];
+            if (!_shader.loadFromMemory(fragment, sf::Shader::Fragment)) {
+                throw std::runtime_error("Could not load fragment shader.");
             }
+        }
 
-            auto result = std::make_shared<sf::Shader>();
+        ShaderProgram(const ShaderProgram&) = delete;
+        ShaderProgram& operator=(const ShaderProgram&) = delete;
 
-            if (!result->loadFromMemory(vertex, sf::Shader::Vertex)) {
-                throw std::runtime_error("Could not load vertex shader.");
+        [[nodiscard]] sf::Shader& shader() {
+            return _shader;
+        }
+
+        /**
+         * uploads the uniforms through the specified function unless they are the ones last uploaded by it
+         */
+        void apply(const ApplyUniforms& apply_uniforms, const Uniforms& uniforms) {
+            if (apply_uniforms == last_apply && uniforms == last_uniforms) {
+                return;
             }
 
-            if (!result->loadFromMemory(fragment, sf::Shader::Fragment)) {
-                throw std::runtime_error("Could not load fragment shader.");
+            apply_uniforms(_shader, uniforms);
+            last_apply = apply_uniforms;
+            last_uniforms = uniforms;
+        }
+
+        /**
+         * forces the next apply to upload, for use after uniforms were set on the shader directly
+         */
+        void invalidate_uniforms() {
+            last_apply = nullptr;
+        }
+    };
+
+    /**
+     *  Manages access to loaded shaders. Shaders are looked up by source once, when an entity is created, which
+     *  returns a handle that is used directly from then on.
+     */
+    class ShaderCache {
+        using CacheEntry = std::pair<std::string, std::string>;
+
+    public:
+        using Handle = std::shared_ptr<ShaderProgram>;
+
+    private:
+        std::map<CacheEntry, Handle> shaders;
+
+    public:
+        Handle load(const std::string &vertex, const std::string &fragment) {
+            CacheEntry cache_entry = std::make_pair(vertex, fragment);
+
+            auto existing = shaders.find(cache_entry);
+            if (existing != shaders.end()) {
+                return existing->second;
             }
 
-            shaders[cache_entry] = result;
+            auto result = std::make_shared<ShaderProgram>(vertex, fragment);
+            shaders.emplace(std::move(cache_entry), result);
             return result;
         }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,64 @@
+#ifndef GRAPH_MOVE_SELECTION_H
+#define GRAPH_MOVE_SELECTION_H
+
+#include <cstddef>
+#include <set>
+#include <stdexcept>
+
+namespace atk {
+
+    /**
+     * Chooses which moves of a pebble game are animated. The others are fast forwarded, so on large graphs a run is
+     * bounded by the speed of the solver rather than by animation time. Moves are numbered from 0.
+     */
+    class MoveSelection {
+    private:
+        /**
+         * every nth move is animated, or none if 0
+         */
+        std::size_t interval = 1;
+
+        std::set<std::size_t> selected;
+
+        explicit MoveSelection(const std::size_t& interval) : interval(interval) {
+        }
+
+    public:
+        static MoveSelection all() {
+            return MoveSelection(1);
+        }
+
+        /**
+         * Animates moves n - 1, 2n - 1 and so on, so that each animated move also shows the n - 1 moves before it.
+         */
+        static MoveSelection every(const std::size_t& n) {
+            if (n == 0) {
+                throw std::runtime_error("Move interval must be positive.");
+            }
+
+            return MoveSelection(n);
+        }
+
+        /**
+         * Animates no moves. Only the final state is shown, unless moves are added with also.
+         */
+        static MoveSelection summary() {
+            return MoveSelection(0);
+        }
+
+        /**
+         * Animates the specified move as well.
+         */
+        MoveSelection& also(const std::size_t& move) {
+            selected.insert(move);
+            return *this;
+        }
+
+        [[nodiscard]] bool animates(const std::size_t& move) const {
+            return (interval != 0 && (move + 1) % interval == 0) || selected.contains(move);
+        }
+    };
+
+}
+
+#endif
@@ -9,9 +9,17 @@
 #include "../utils/common_manipulations.h"
 #include "../utils/color.h"
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include "../scene_graph.h"
+#include "../utils/symbol.h"
 
 namespace atk {
 
@@ -28,165 +36,403 @@ namespace atk {
         using Move = ffnx::pebblegame::PebbleGame2D<Graph>::Move;
         using PG2D = ffnx::pebblegame::PebbleGame2D<Graph>;
 
+    public:
+        /**
+         * Directed edge of the game graph, by the scene node names of the edge, the edge in the opposite direction
+         * and its tail and head vertices.
+         */
+        struct EdgeState {
+            Symbol id;
+            Symbol inverted_id;
+            Symbol v0;
+            Symbol v1;
+        };
+
+        /**
+         * Scene node names of the vertices of the input graph and of both directions of each of its edges. Interned
+         * once, so that showing a move needs no formatting or interning. Never modified once built, so it may be
+         * shared between threads.
+         */
+        class SceneIds {
+        private:
+            using Vertex = Graph::vertex_descriptor;
+
+            std::map<Vertex, Symbol> vertices;
+            std::map<std::pair<Vertex, Vertex>, EdgeState> edges;
+
+        public:
+            explicit SceneIds(Graph& graph) {
+                for (const auto &v : graph.vertices()) {
+                    vertices.emplace(v, Symbol(graph[v]));
+                }
+
+                for (const auto &e : graph.edges()) {
+                    auto v0_v1 = graph.vertices_for_edge(e);
+                    add_edge(graph, v0_v1.first, v0_v1.second);
+                    add_edge(graph, v0_v1.second, v0_v1.first);
+                }
+            }
+
+            [[nodiscard]] const Symbol& vertex(const Vertex& v) const {
+                auto it = vertices.find(v);
+                if (it == vertices.end()) {
+                    throw std::runtime_error("Vertex not present in the input graph.");
+                }
+
+                return it->second;
+            }
+
+            /**
+             * @return the edge from v0 to v1
+             */
+            [[nodiscard]] const EdgeState& edge(const Vertex& v0, const Vertex& v1) const {
+                auto it = edges.find(std::make_pair(v0, v1));
+                if (it == edges.end()) {
+                    throw std::runtime_error("Edge not present in the input graph.");
+                }
+
+                return it->second;
+            }
+
+            /**
+             * @return the edge of the input graph, in the direction its vertices are reported in
+             */
+            [[nodiscard]] const EdgeState& edge(Graph& graph, const Graph::edge_descriptor& e) const {
+                auto v0_v1 = graph.vertices_for_edge(e);
+                return edge(v0_v1.first, v0_v1.second);
+            }
+
+        private:
+            void add_edge(Graph& graph, const Vertex& v0, const Vertex& v1) {
+                const std::string& name0 = graph[v0];
+                const std::string& name1 = graph[v1];
+
+                edges.emplace(std::make_pair(v0, v1), EdgeState {
+                        Symbol(edge_id(name0, name1)),
+                        Symbol(edge_id(name1, name0)),
+                        Symbol(name0),
+                        Symbol(name1)});
+            }
+        };
+
+        /**
+         * What a move changed in the scene.
+         */
+        struct Changes {
+            sptr<Move> move;
+
+            /**
+             * new pebble ids of the vertices whose pebbles changed, by the scene node name of the vertex
+             */
+            std::vector<std::pair<Symbol, std::vector<Symbol>>> vertex_pebbles;
+
+            /**
+             * pebbles that are no longer on any vertex
+             */
+            std::vector<Symbol> removed_pebbles;
+
+            /**
+             * edges that were not shown before, either because they are new or because they were reversed
+             */
+            std::vector<EdgeState> edges;
+        };
+
+        /**
+         * Remembers the state of the game after the previous move, so that each move can be reduced to the changes it
+         * made. Reads the game while it is paused in its move callback and only touches its own state, so it may run
+         * on the game's thread. Pebble numbers are compared as they are, and only interned the first time a pebble
+         * changes.
+         */
+        class ChangeTracker {
+        private:
+            sptr<const SceneIds> ids;
+            sptr<Graph> graph;
+
+            std::unordered_map<Symbol, std::vector<std::size_t>, Symbol::Hash> vertex_pebbles;
+
+            /**
+             * pebbles on the board after the previous move, and the number of the last move each pebble was seen on
+             */
+            std::vector<std::size_t> pebbles_on_board;
+            std::vector<std::uint64_t> pebble_seen_move;
+            std::uint64_t move_count = 0;
+
+            std::vector<std::optional<Symbol>> pebble_ids;
+
+            std::unordered_set<Symbol, Symbol::Hash> shown_edges;
+
+            // per move scratch storage, kept to avoid reallocation
+            std::vector<std::size_t> vertex_scratch;
+            std::vector<std::size_t> board_scratch;
+
+        public:
+            ChangeTracker(sptr<const SceneIds> ids, sptr<Graph> graph) :
+                    ids(std::move(ids)),
+                    graph(std::move(graph)) {
+            }
+
+            /**
+             * @return the changes since the previous move, or everything if this is the first
+             */
+            Changes changes(PG2D& pebblegame, const sptr<Move>& move) {
+                Changes result;
+                result.move = move;
+                move_count++;
+
+                auto& game_graph = pebblegame.get_game_graph();
+
+                board_scratch.clear();
+                for (const auto &internal_vertex : game_graph.graph().vertices()) {
+                    const auto& vertex_id = ids->vertex(game_graph.external_vert(internal_vertex));
+
+                    vertex_scratch.clear();
+                    for (const auto &i : game_graph.get_vert_pebbles(internal_vertex).pebbles()) {
+                        auto pebble = (std::size_t)i;
+                        vertex_scratch.push_back(pebble);
+                        board_scratch.push_back(pebble);
+
+                        if (pebble_seen_move.size() <= pebble) {
+                            pebble_seen_move.resize(pebble + 1, 0);
+                        }
+                        pebble_seen_move[pebble] = move_count;
+                    }
+
+                    auto& previous = vertex_pebbles[vertex_id];
+                    if (previous != vertex_scratch) {
+                        previous = vertex_scratch;
+
+                        std::vector<Symbol> ids_on_vertex;
+                        for (const auto &pebble : vertex_scratch) {
+                            ids_on_vertex.push_back(pebble_id(pebble));
+                        }
+                        result.vertex_pebbles.emplace_back(vertex_id, std::move(ids_on_vertex));
+                    }
+                }
+
+                for (const auto &pebble : pebbles_on_board) {
+                    if (pebble_seen_move[pebble] != move_count) {
+                        result.removed_pebbles.push_back(pebble_id(pebble));
+                    }
+                }
+                std::swap(pebbles_on_board, board_scratch);
+
+                for (const auto &e : game_graph.graph().edges()) {
+                    const auto& edge = ids->edge(*graph, game_graph.external_edge(e));
+
+                    if (!shown_edges.contains(edge.id)) {
+                        shown_edges.insert(edge.id);
+                        shown_edges.erase(edge.inverted_id);
+                        result.edges.push_back(edge);
+                    }
+                }
+
+                return result;
+            }
+
+        private:
+            const Symbol& pebble_id(const std::size_t& pebble) {
+                if (pebble_ids.size() <= pebble) {
+                    pebble_ids.resize(pebble + 1);
+                }
+
+                if (!pebble_ids[pebble].has_value()) {
+                    pebble_ids[pebble] = Symbol(std::to_string(pebble));
+                }
+
+                return pebble_ids[pebble].value();
+            }
+        };
+
+    private:
+
         sptr<PG2D> pebblegame;
         sptr<SceneNode> scene_graph;
         sptr<Cluster> game_cluster;
+        sptr<Graph> graph;
+
+        sptr<const SceneIds> ids;
+
+        NodeHandle edges;
+        NodeHandle nodes;
+        NodeHandle pebbles;
+
+        inline static const Symbol PEBBLE_TARGET = Symbol("pebble_target");
+
+        /**
+         * reduces the moves passed to update(move) to changes
+         */
+        ChangeTracker tracker;
+
+        /**
+         * edges currently drawn in the dfs color
+         */
+        std::unordered_set<Symbol, Symbol::Hash> highlighted_edges;
 
     public:
         SceneGraphPebbleGame(sptr<PG2D> pebblegame,
                              sptr<Cluster> game_cluster,
                              sptr<SceneNode> scene_graph) :
             pebblegame(pebblegame),
+            scene_graph(scene_graph),
             game_cluster(game_cluster),
-            scene_graph(scene_graph) {
+            graph(game_cluster->graph().lock()),
+            ids(std::make_shared<SceneIds>(*graph)),
+            edges(scene_graph->resolve("edges")),
+            nodes(scene_graph->resolve("nodes")),
+            pebbles(scene_graph->resolve("pebbles")),
+            tracker(ids, graph) {
 
             init();
         }
 
+        [[nodiscard]] const SceneIds& scene_ids() const {
+            return *ids;
+        }
+
+        /**
+         * @return a tracker for passing the game's moves to update from elsewhere, for example another thread
+         */
+        [[nodiscard]] ChangeTracker make_change_tracker() const {
+            return ChangeTracker(ids, graph);
+        }
+
+        /**
+         * Shows the current state of the game. Must be called from within the game's move callback.
+         */
         void update(atk::Director& director,
                     atk::Timeline& timeline,
                     const sptr<ShaderCache>& shader_cache,
                     const sptr<PG2D::Move>& move) {
 
-            update_pebbles(director, shader_cache);
-            update_edges(director, shader_cache);
+            update(director, timeline, shader_cache, tracker.changes(*pebblegame, move));
+        }
+
+        /**
+         * Shows the changes made by a move. Only the vertices, edges and highlights that changed are touched. Must be
+         * passed the changes of every move in order, starting from the first.
+         */
+        void update(atk::Director& director,
+                    atk::Timeline& timeline,
+                    const sptr<ShaderCache>& shader_cache,
+                    const Changes& changes) {
+
+            update_pebbles(director, shader_cache, changes);
+            update_edges(director, changes);
 
-            highlight_edges(director, timeline, shader_cache, move);
+            highlight_edges(timeline, changes.move);
         }
 
-    private:
+        /**
+         * Applies the changes made by a move to the scene at once, leaving it as update followed by playing the
+         * director to completion would. Nothing is animated or rendered.
+         */
+        void fast_forward(atk::Director& director,
+                          atk::Timeline& timeline,
+                          const sptr<ShaderCache>& shader_cache,
+                          const Changes& changes) {
 
-        void highlight_edges(atk::Director& director,
-                             atk::Timeline& timeline,
-                             const sptr<ShaderCache>& shader_cache,
-                             const sptr<PG2D::Move>& move) {
+            update(director, timeline, shader_cache, changes);
+            director.skip();
+        }
 
-            std::set<std::string> dfs_edge_ids;
+    private:
+
+        void highlight_edges(atk::Timeline& timeline, const sptr<PG2D::Move>& move) {
+            std::unordered_set<Symbol, Symbol::Hash> dfs_edge_ids;
             for (auto &e : move->dfs_edges) {
-                auto e_id = edge_to_scene_node_id(e, false);
-                dfs_edge_ids.insert(e_id);
+                const auto& e_id = ids->edge(*graph, e).id;
+                if (edges->contains(e_id)) {
+                    dfs_edge_ids.insert(e_id);
+                }
             }
 
             sf::Color base_color = atk::constants::color::SolarizedDark::base3;
             sf::Color dfs_color = atk::constants::color::SolarizedDark::magenta;
 
+            for (const auto& id : highlighted_edges) {
+                if (!dfs_edge_ids.contains(id)) {
+                    fade_edge(timeline, id, base_color);
+                }
+            }
 
-            for (const auto& kv : scene_graph->get("edges")->children()) {
-                auto arrow = kv.second->get_drawable_as<Arrow>();
-
-                auto current_color = arrow->get_fill_color();
-                auto target_color = dfs_edge_ids.contains(kv.first) ? dfs_color : base_color;
-
-                if (current_color != target_color) {
-                    timeline.add(std::make_shared<FireOnceScheduler>(0, 0.5),
-                            std::make_shared<InterpolatedAnimation>(
-                                    InterpolatedAnimation::ease_in_out_interpolation(),
-                                    [target_color, current_color, arrow](float v){
-                                        arrow->set_fill_color(atk::ColorUtils::lerp(v, current_color, target_color));
-                                    }));
+            for (const auto& id : dfs_edge_ids) {
+                if (!highlighted_edges.contains(id)) {
+                    fade_edge(timeline, id, dfs_color);
                 }
             }
-        }
 
-        void update_edges(atk::Director& director, const sptr<ShaderCache>& shader_cache) {
-            auto game_edges = pebblegame->get_game_graph().graph().edges();
+            highlighted_edges = std::move(dfs_edge_ids);
+        }
 
-            // determine if any edges need to be added/destroyed
-            for (const auto& e : game_edges) {
-                auto external_edge = pebblegame->get_game_graph().external_edge(e);
+        void fade_edge(atk::Timeline& timeline, const Symbol& id, const sf::Color& target_color) {
+            auto arrow = edges->get(id)->get_drawable_as<Arrow>();
+            auto current_color = arrow->get_fill_color();
 
-                hide_inverted_edge_if_present(external_edge, director);
-                show_edge_node(external_edge, director);
+            if (current_color != target_color) {
+                timeline.channels().arrow_fill_color.add(
+                        arrow, current_color, target_color, 0, 0.5, Easing::EASE_IN_OUT);
             }
         }
 
-        void show_edge_node(const Graph::edge_descriptor& e, Director &director) {
-            auto id = edge_to_scene_node_id(e, false);
-
-            auto graph = game_cluster->graph().lock();
-
-            auto v0_v1 = graph->vertices_for_edge(e);
-
-            std::string v0 = (*graph)[v0_v1.first];
-            std::string v1 = (*graph)[v0_v1.second];
+        void update_edges(atk::Director& director, const Changes& changes) {
+            // only edges that are new or reversed need to be shown, and their inverses hidden
+            for (const auto& e : changes.edges) {
+                hide_inverted_edge_if_present(e, director);
+                show_edge_node(e, director);
+            }
+        }
 
-            if (!scene_graph->get("edges")->contains(id)) {
-                scene_graph->get("edges")->add(id, std::make_unique<Arrow>(
-                        scene_graph->get("edges"),
-                        scene_graph->get("nodes")->get(v1),
-                        scene_graph->get("nodes")->get(v0)));
-                atk::CommonManipulations::set_unbuilt(scene_graph->get("edges")->get(id));
+        void show_edge_node(const EdgeState& e, Director &director) {
+            if (!edges->contains(e.id)) {
+                edges->add(e.id.str(), std::make_unique<Arrow>(
+                        edges.get(),
+                        nodes->get(e.v1),
+                        nodes->get(e.v0)));
+                atk::CommonManipulations::set_unbuilt(edges->get(e.id));
             }
 
-            auto node = scene_graph->get("edges")->get(id);
+            auto node = edges->get(e.id);
 
             if (node->get_drawable_as<Buildable>()->get_build_percent() != 1) {
                 director.build(node);
             }
         }
 
-        void hide_inverted_edge_if_present(const Graph::edge_descriptor& e, Director &director) {
-            auto id = edge_to_scene_node_id(e, true);
-
-            if (scene_graph->get("edges")->contains(id)) {
-                auto node = scene_graph->get("edges")->get(id);
+        void hide_inverted_edge_if_present(const EdgeState& e, Director &director) {
+            if (edges->contains(e.inverted_id)) {
+                auto node = edges->get(e.inverted_id);
                 if (node->get_drawable_as<Buildable>()->get_build_percent() != 0) {
                     director.unbuild(node);
                 }
             }
         }
 
-        [[nodiscard]] std::string edge_to_scene_node_id(const Graph::edge_descriptor& e, bool should_invert) const {
-            auto graph = game_cluster->graph().lock();
-
-            auto v0_v1 = graph->vertices_for_edge(e);
-
-            std::string v0 = (*graph)[v0_v1.first];
-            std::string v1 = (*graph)[v0_v1.second];
-
-            if (should_invert) {
-                std::swap(v0, v1);
-            }
-
+        static std::string edge_id(const std::string& v0, const std::string& v1) {
             return (std::stringstream() << v0 << "->" << v1).str();
         }
 
-        void update_pebbles(atk::Director& director, const sptr<ShaderCache>& shader_cache) {
-            // determine the set of nodes that require pebbles to be rearranged
-            std::map<std::string, std::vector<std::string>> pebble_arrangements;
-            std::set<std::string> pebbles_on_board;
-
-            for (const auto &internal_vertex : pebblegame->get_game_graph().graph().vertices()) {
-                auto external_vertex = pebblegame->get_game_graph().external_vert(internal_vertex);
-
-                // determine the scene graph node:
-                std::string node_id = (*game_cluster->graph().lock())[external_vertex];
-
-                pebble_arrangements[node_id] = std::vector<std::string>();
-                for (const auto &i : pebblegame->get_game_graph().get_vert_pebbles(internal_vertex).pebbles()) {
-                    auto pebble_id = std::to_string(i);
-                    pebble_arrangements[node_id].push_back(pebble_id);
-                    pebbles_on_board.insert(pebble_id);
+        void update_pebbles(atk::Director& director, const sptr<ShaderCache>& shader_cache, const Changes& changes) {
+            for (const auto &pid : changes.removed_pebbles) {
+                if (!pebbles->contains(pid)) {
+                    continue;
                 }
-            }
 
-            // determine which pebbles have been removed from the board
-            for (const auto &kv : scene_graph->get("pebbles")->children()) {
-                if (!pebbles_on_board.contains(kv.first) && scene_graph->get("pebbles")->get(kv.first)->get_drawable_as<Buildable>()->get_build_percent() != 0) {
-                    director.unbuild(scene_graph->get("pebbles")->get(kv.first), Sequencer{ 0, 0.5, 0.5 });
+                auto node = pebbles->get(pid);
+                if (node->get_drawable_as<Buildable>()->get_build_percent() != 0) {
+                    director.unbuild(node, Sequencer{ 0, 0.5, 0.5 });
                 }
             }
 
-            for (const auto &kv : pebble_arrangements) {
-                auto target_node = scene_graph->get("nodes")->get(kv.first);
+            // only vertices whose set of pebbles changed are rearranged
+            for (const auto &kv : changes.vertex_pebbles) {
+                auto target_node = nodes->get(kv.first);
 
                 std::vector<sptr<atk::SceneNode>> pebbles_to_move;
                 for (const auto& pid : kv.second) {
                     pebbles_to_move.push_back(this->get_pebble_node(director, shader_cache, pid));
                 }
 
-                // only queue animation if the current set of pebbles differs from the existing set on the node
-                director.arrange(target_node->get("pebble_target"),
+                director.arrange(target_node->get(PEBBLE_TARGET),
                                  pebbles_to_move,
                                  Sequencer { 0, 0.5, 0.5 },
                                  Sequencer { 0, 0.5, 0.5 });
@@ -202,8 +448,8 @@ namespace atk {
             scene_graph->add("pebbles");
 
             // create nodes to serve as the targets for all pebbles
-            for (auto &kv : scene_graph->get("nodes")->children()) {
-                auto pt = scene_graph->get("nodes")->get(kv.first)->add("pebble_target");
+            for (auto &kv : nodes->children()) {
+                auto pt = kv.second->add(PEBBLE_TARGET.str());
 
                 pt->transform().translate(0, -10);
             }
@@ -212,12 +458,12 @@ namespace atk {
         /**
          * @return the scene node associated with the specified pebble id. Creates one if not present.
          */
-        sptr<SceneNode> get_pebble_node(Director& director, sptr<ShaderCache> shader_cache, const std::string& id) {
-            if (scene_graph->get("pebbles")->contains(id)) {
-                return scene_graph->get("pebbles")->get(id);
+        sptr<SceneNode> get_pebble_node(Director& director, sptr<ShaderCache> shader_cache, const Symbol& id) {
+            if (pebbles->contains(id)) {
+                return pebbles->get(id);
             }
 
-            auto new_node = scene_graph->get("pebbles")->add(id, std::make_unique<atk::Dot>(3, shader_cache));
+            auto new_node = pebbles->add(id.str(), std::make_unique<atk::Dot>(3, shader_cache));
             director.build(new_node);
 
             return new_node;
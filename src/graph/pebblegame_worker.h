@@ -0,0 +1,97 @@
+#ifndef GRAPH_PEBBLEGAME_WORKER_H
+#define GRAPH_PEBBLEGAME_WORKER_H
+
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include "./pebblegame.h"
+#include "../utils/bounded_queue.h"
+
+namespace atk {
+
+    /**
+     * Runs a pebble game on its own thread, so the solver never waits for moves to be animated. Each move is reduced
+     * to the changes it made and queued until the animating thread takes it. The solver only blocks once the queue is
+     * full.
+     */
+    class PebbleGameWorker {
+    private:
+        template<typename T>
+        using sptr = std::shared_ptr<T>;
+
+        using Graph = atk::GraphVizFlowGraphFactory::ffnx_graph;
+        using Move = ffnx::pebblegame::PebbleGame2D<Graph>::Move;
+        using PG2D = ffnx::pebblegame::PebbleGame2D<Graph>;
+        using Changes = SceneGraphPebbleGame::Changes;
+
+        /**
+         * thrown from the move callback to leave the game early once nobody is taking moves any more
+         */
+        struct Stopped {};
+
+        sptr<PG2D> pebblegame;
+
+        SceneGraphPebbleGame::ChangeTracker tracker;
+
+        BoundedQueue<Changes> moves;
+
+        std::thread thread;
+
+    public:
+        /**
+         * number of moves the solver may run ahead. Each queued move only holds what it changed.
+         */
+        static constexpr std::size_t DEFAULT_CAPACITY = 4096;
+
+        /**
+         * Starts the game. The game must not be used elsewhere until the worker is destroyed.
+         * @param tracker from SceneGraphPebbleGame::make_change_tracker of the scene the moves are shown on
+         */
+        PebbleGameWorker(sptr<PG2D> pebblegame,
+                         SceneGraphPebbleGame::ChangeTracker tracker,
+                         const std::size_t& capacity = DEFAULT_CAPACITY) :
+                pebblegame(std::move(pebblegame)),
+                tracker(std::move(tracker)),
+                moves(capacity) {
+
+            thread = std::thread([this]() { work(); });
+        }
+
+        PebbleGameWorker(const PebbleGameWorker&) = delete;
+        PebbleGameWorker& operator=(const PebbleGameWorker&) = delete;
+
+        ~PebbleGameWorker() {
+            moves.close();
+            thread.join();
+        }
+
+        /**
+         * Blocks until the solver has made another move. Errors thrown by the solver are rethrown here, after the
+         * moves made before them.
+         * @return the changes made by the next move, or nullopt once the game is over
+         */
+        std::optional<Changes> next() {
+            return moves.pop();
+        }
+
+    private:
+        void work() {
+            try {
+                pebblegame->run([this](const sptr<Move>& move) {
+                    if (!moves.push(tracker.changes(*pebblegame, move))) {
+                        throw Stopped();
+                    }
+                });
+                moves.close();
+            } catch (const Stopped&) {
+            } catch (...) {
+                moves.close(std::current_exception());
+            }
+        }
+    };
+
+}
+
+#endif
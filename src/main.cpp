@@ -16,11 +16,14 @@
 #include "animation/timeline.h"
 #include "animation/director.h"
 #include "animation/sfml_clock_timer.h"
+#include "animation/fixed_step_timer.h"
 #include "rendering/renderer.h"
 #include "entities/empty.h"
 #include "entities/dot.h"
 #include "graph/graphviz_parser.h"
 #include "graph/pebblegame.h"
+#include "graph/pebblegame_worker.h"
+#include "graph/move_selection.h"
 #include "utils/common_manipulations.h"
 #include "utils/color.h"
 
@@ -37,11 +40,39 @@ template<typename T>
 using sptr = std::shared_ptr<T>;
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        throw std::runtime_error("Expected two arguments");
+    // options choosing which moves are animated, the rest are fast forwarded: --every=N animates every nth move,
+    // --move=I also animates move I and --summary animates none, only showing the final state
+    std::vector<std::string> args;
+    std::optional<std::size_t> move_interval;
+    std::vector<std::size_t> selected_moves;
+    bool summary = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg.starts_with("--every=")) {
+            move_interval = std::stoul(arg.substr(std::string("--every=").size()));
+        } else if (arg.starts_with("--move=")) {
+            selected_moves.push_back(std::stoul(arg.substr(std::string("--move=").size())));
+        } else if (arg == "--summary") {
+            summary = true;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() != 2 && args.size() != 3) {
+        throw std::runtime_error("Expected two or three arguments");
     }
 
-    atk::GraphVizModel template_graph_model = atk::GraphVizModel::read_from_file(argv[1]);
+    auto moves_to_animate = summary ? atk::MoveSelection::summary()
+            : move_interval.has_value() ? atk::MoveSelection::every(move_interval.value())
+            : atk::MoveSelection::all();
+    for (const auto &move : selected_moves) {
+        moves_to_animate.also(move);
+    }
+
+    atk::GraphVizModel template_graph_model = atk::GraphVizModel::read_from_file(args[0]);
     std::shared_ptr<Graph> graph = atk::GraphVizFlowGraphFactory::get_graph(template_graph_model);
 
     auto cluster = Cluster::Builder::of_graph(graph);
@@ -61,6 +92,7 @@ int main(int argc, char* argv[]) {
     game_graph->get("edges")->clear();
 
     auto scene = std::make_shared<atk::SceneNode>();
+    scene->use_flat_storage();
 
     // arranging scene
     {
@@ -72,64 +104,123 @@ int main(int argc, char* argv[]) {
         atk::CommonManipulations::set_built(scene);
     }
 
+    // the template graph only changes when an edge highlight fades, so it is drawn from a cached texture
+    template_graph->set_cached_layer(true);
+
     int window_width = 800;
     int window_height = 800;
 
-    auto renderer = std::make_shared<atk::WindowRenderer>(window_width, window_height,
-                                                          atk::constants::color::SolarizedDark::base03,
-                                                          false);
-    scene->translate_to_world_coordinate(window_width * 0.5f, window_height * 0.5f);
+    float time_scale = std::stof(args[1]);
+
+    std::shared_ptr<atk::Renderer> renderer;
+    std::shared_ptr<atk::OffscreenRenderer> offscreen_renderer;
+    std::unique_ptr<atk::Timer> timer;
+
+    if (args.size() == 3) {
+        // export frames to the specified directory instead of opening a window
+        offscreen_renderer = std::make_shared<atk::OffscreenRenderer>(window_width, window_height,
+                                                                      atk::constants::color::SolarizedDark::base03,
+                                                                      std::make_shared<atk::PngSequenceSink>(args[2]));
+        renderer = offscreen_renderer;
+
+        auto fixed_step_timer = std::make_unique<atk::FixedStepTimer>(60.0f);
+        fixed_step_timer->set_scale(time_scale);
+        timer = std::move(fixed_step_timer);
+    } else {
+        renderer = std::make_shared<atk::WindowRenderer>(window_width, window_height,
+                                                         atk::constants::color::SolarizedDark::base03,
+                                                         false);
+
+        auto clock_timer = std::make_unique<atk::SFMLClockTimer>();
+        clock_timer->set_scale(time_scale);
+        timer = std::move(clock_timer);
+    }
+
+    // the scene is arranged around the origin
+    renderer->set_camera(std::make_shared<atk::Camera>(sf::Vector2f(0, 0)));
 
-    auto timer = atk::SFMLClockTimer();
-    timer.set_scale(std::stof(argv[2]));
     auto timeline = std::make_shared<atk::Timeline>();
     atk::Director director(scene, timeline, renderer);
 
     auto scene_graph_pebblegame = atk::SceneGraphPebbleGame(pebblegame, cluster, game_graph);
 
-    pebblegame->run([&](std::shared_ptr<Move> move){
+    auto template_edges = template_graph->resolve("edges");
+
+    // the solver runs ahead on its own thread, while its moves are animated here
+    atk::PebbleGameWorker worker(pebblegame, scene_graph_pebblegame.make_change_tracker());
+
+    const auto& scene_ids = scene_graph_pebblegame.scene_ids();
+    std::optional<atk::Symbol> highlighted_template_edge;
+
+    std::size_t move_index = 0;
+    bool last_move_shown = true;
+
+    while (auto changes = worker.next()) {
         std::cout << "Move" << std::endl;
 
-        scene_graph_pebblegame.update(director, *timeline, shader_cache, move);
+        bool animate = moves_to_animate.animates(move_index++);
 
-        director.play(timer);
+        if (animate) {
+            scene_graph_pebblegame.update(director, *timeline, shader_cache, changes.value());
+            director.play(*timer);
+        } else {
+            scene_graph_pebblegame.fast_forward(director, *timeline, shader_cache, changes.value());
+        }
 
-        auto edge_being_added = move->edge_being_added;
+        auto edge_being_added = changes->move->edge_being_added;
 
-        std::string input_edge_to_highlight;
+        std::optional<atk::Symbol> input_edge_to_highlight;
         if (edge_being_added.has_value()) {
-            auto v0 = (*graph)[edge_being_added.value().first];
-            auto v1 = (*graph)[edge_being_added.value().second];
-
-            input_edge_to_highlight = (std::stringstream() << v0 << "->" << v1).str();
+            input_edge_to_highlight = scene_ids.edge(edge_being_added->first, edge_being_added->second).id;
         }
 
         auto default_col = atk::constants::color::SolarizedDark::base3;
         auto dfs_col = atk::constants::color::SolarizedDark::magenta;
         auto add_col = atk::constants::color::SolarizedDark::magenta;
 
-        for (const auto &kv : template_graph->get("edges")->children()) {
-            auto target_col = (kv.first == input_edge_to_highlight) ? add_col : default_col;
-            auto arrow = template_graph->get("edges")->get(kv.first)->get_drawable_as<atk::Arrow>();
+        // template arrows are all drawn in the default color, so only the previous and next highlights can change
+        auto fade_template_edge = [&](const std::optional<atk::Symbol>& id, const sf::Color& target_col) {
+            if (!id.has_value() || !template_edges->contains(id.value())) {
+                return;
+            }
+
+            auto arrow = template_edges->get(id.value())->get_drawable_as<atk::Arrow>();
             auto start_col = arrow->get_fill_color();
 
             if (start_col != target_col) {
-                timeline->add(
-                        std::make_unique<atk::FireOnceScheduler>(0, 0.5),
-                        std::make_unique<atk::InterpolatedAnimation>(
-                                atk::InterpolatedAnimation::ease_out_interpolation(),
-                                [arrow, start_col, target_col](float v) {
-                                    arrow->set_fill_color(atk::ColorUtils::lerp(v, start_col, target_col));
-                                }));
+                timeline->channels().arrow_fill_color.add(
+                        arrow, start_col, target_col, 0, 0.5, atk::Easing::EASE_OUT);
             }
+        };
+
+        if (highlighted_template_edge != input_edge_to_highlight) {
+            fade_template_edge(highlighted_template_edge, default_col);
         }
+        fade_template_edge(input_edge_to_highlight, add_col);
+        highlighted_template_edge = input_edge_to_highlight;
 
-        director.play(timer);
-    });
+        if (animate) {
+            director.play(*timer);
+        } else {
+            director.skip();
+        }
+
+        last_move_shown = animate;
+    }
 
     std::cout << "Done" << std::endl;
 
-    director.play_forever(timer );
+    if (!last_move_shown) {
+        director.show();
+    }
+
+    if (offscreen_renderer != nullptr) {
+        offscreen_renderer->finish();
+        std::cout << "Exported " << offscreen_renderer->frame_count() << " frames" << std::endl;
+        return 0;
+    }
+
+    director.play_forever(*timer);
 
     return 0;
 }
@@ -0,0 +1,161 @@
+#ifndef RENDERING_CACHED_LAYER_H
+#define RENDERING_CACHED_LAYER_H
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace atk {
+
+    /**
+     * Drawn in place of a subtree that is marked as a cached layer. The subtree is rasterised into an offscreen
+     * texture at the resolution it covers on screen, and the texture is composited as a single sprite until the layer
+     * is invalidated or the area of the view it covers changes. The transform it is drawn with is ignored, as the
+     * contents are drawn with their own world transforms.
+     */
+    class CachedLayer : public sf::Drawable {
+    public:
+        /**
+         * draws the contents onto the target in its current view. The world space area being rasterised is passed
+         * along for culling.
+         */
+        using DrawContents = std::function<void(sf::RenderTarget&, const sf::FloatRect&)>;
+
+        /**
+         * world bounds of the contents, or nullopt if they are not known and the whole view must be rasterised
+         */
+        using WorldBounds = std::function<std::optional<sf::FloatRect>()>;
+
+    private:
+        /**
+         * extra pixels rasterised around the bounds, so antialiased edges are not clipped
+         */
+        static constexpr int MARGIN_PIXELS = 2;
+
+        DrawContents draw_contents;
+        WorldBounds world_bounds;
+
+        std::uint64_t version = 0;
+
+        /**
+         * everything the texture depends on. The contents are rasterised again only when this differs from the key
+         * of the last rasterisation.
+         */
+        struct Key {
+            std::uint64_t version;
+            sf::IntRect pixels;
+            sf::FloatRect area;
+
+            bool operator==(const Key& other) const {
+                return version == other.version && pixels == other.pixels && area == other.area;
+            }
+        };
+
+        mutable std::optional<Key> key;
+        mutable std::unique_ptr<sf::RenderTexture> texture;
+        mutable sf::Vector2u capacity;
+        mutable std::size_t raster_count = 0;
+
+    public:
+        CachedLayer(DrawContents draw_contents, WorldBounds world_bounds) :
+                draw_contents(std::move(draw_contents)),
+                world_bounds(std::move(world_bounds)) {
+        }
+
+        /**
+         * Marks the contents as changed, so they are rasterised again when next drawn.
+         */
+        void invalidate() {
+            version++;
+        }
+
+        /**
+         * @return how many times the contents have been rasterised
+         */
+        [[nodiscard]] std::size_t rasterizations() const {
+            return raster_count;
+        }
+
+    protected:
+        void draw(sf::RenderTarget &target, sf::RenderStates /* states */) const override {
+            auto target_size = target.getSize();
+            sf::IntRect pixels(0, 0, (int)target_size.x, (int)target_size.y);
+
+            auto bounds = world_bounds();
+            if (bounds.has_value()) {
+                auto b = bounds.value();
+                auto p0 = target.mapCoordsToPixel(sf::Vector2f(b.left, b.top));
+                auto p1 = target.mapCoordsToPixel(sf::Vector2f(b.left + b.width, b.top + b.height));
+
+                int left = std::max(0, std::min(p0.x, p1.x) - MARGIN_PIXELS);
+                int top = std::max(0, std::min(p0.y, p1.y) - MARGIN_PIXELS);
+                int right = std::min((int)target_size.x, std::max(p0.x, p1.x) + MARGIN_PIXELS + 1);
+                int bottom = std::min((int)target_size.y, std::max(p0.y, p1.y) + MARGIN_PIXELS + 1);
+
+                if (right <= left || bottom <= top) {
+                    return;
+                }
+
+                pixels = sf::IntRect(left, top, right - left, bottom - top);
+            }
+
+            auto a0 = target.mapPixelToCoords(sf::Vector2i(pixels.left, pixels.top));
+            auto a1 = target.mapPixelToCoords(sf::Vector2i(pixels.left + pixels.width, pixels.top + pixels.height));
+            sf::FloatRect area(a0.x, a0.y, a1.x - a0.x, a1.y - a0.y);
+
+            Key new_key {version, pixels, area};
+            if (key != new_key) {
+                rasterize(pixels, area);
+                key = new_key;
+            }
+
+            sf::Sprite sprite(texture->getTexture(), sf::IntRect(0, 0, pixels.width, pixels.height));
+            sprite.setPosition((float)pixels.left, (float)pixels.top);
+
+            // the texture holds colors already multiplied by their alpha
+            sf::RenderStates composite_states(sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha));
+
+            auto view = target.getView();
+            target.setView(sf::View(sf::FloatRect(0, 0, (float)target_size.x, (float)target_size.y)));
+            target.draw(sprite, composite_states);
+            target.setView(view);
+        }
+
+    private:
+        /**
+         * draws the contents covering the area into the top left pixels of the texture, growing it if needed
+         */
+        void rasterize(const sf::IntRect& pixels, const sf::FloatRect& area) const {
+            auto width = (unsigned int)pixels.width;
+            auto height = (unsigned int)pixels.height;
+
+            if (texture == nullptr || capacity.x < width || capacity.y < height) {
+                capacity = sf::Vector2u(std::max(capacity.x, width), std::max(capacity.y, height));
+
+                sf::ContextSettings settings;
+                settings.antialiasingLevel = 8;
+                texture = std::make_unique<sf::RenderTexture>();
+                if (!texture->create(capacity.x, capacity.y, settings)) {
+                    throw std::runtime_error("Could not create cached layer texture.");
+                }
+            }
+
+            sf::View view(area);
+            view.setViewport(sf::FloatRect(0, 0, (float)width / (float)capacity.x, (float)height / (float)capacity.y));
+
+            texture->setView(view);
+            texture->clear(sf::Color::Transparent);
+            draw_contents(*texture, area);
+            texture->display();
+
+            raster_count++;
+        }
+    };
+
+}
+
+#endif
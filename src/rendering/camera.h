@@ -0,0 +1,101 @@
+#ifndef RENDERING_CAMERA_H
+#define RENDERING_CAMERA_H
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+
+namespace atk {
+
+    /**
+     * Pan and zoom applied to the scene by a Renderer. The centre is the world point shown in the middle of the
+     * target, and zoom is the number of pixels per world unit.
+     */
+    class Camera {
+    private:
+        sf::Vector2f _center;
+
+        float _zoom = 1.0f;
+
+        float min_zoom = 1.0f / 256.0f;
+        float max_zoom = 64.0f;
+
+    public:
+        explicit Camera(const sf::Vector2f& center = sf::Vector2f(0, 0), const float& zoom = 1.0f) :
+                _center(center) {
+            set_zoom(zoom);
+        }
+
+        [[nodiscard]] const sf::Vector2f& get_center() const {
+            return _center;
+        }
+
+        void set_center(const sf::Vector2f& center) {
+            _center = center;
+        }
+
+        [[nodiscard]] float get_zoom() const {
+            return _zoom;
+        }
+
+        void set_zoom(const float& zoom) {
+            _zoom = std::clamp(zoom, min_zoom, max_zoom);
+        }
+
+        void set_zoom_limits(const float& new_min_zoom, const float& new_max_zoom) {
+            if (new_min_zoom <= 0 || new_max_zoom < new_min_zoom) {
+                throw std::runtime_error("Invalid zoom limits.");
+            }
+
+            min_zoom = new_min_zoom;
+            max_zoom = new_max_zoom;
+            set_zoom(_zoom);
+        }
+
+        /**
+         * Moves the view so that the scene follows a drag of the specified number of pixels.
+         */
+        void pan_pixels(const sf::Vector2f& offset) {
+            _center -= offset / _zoom;
+        }
+
+        /**
+         * Multiplies the zoom by the specified factor, keeping the world point shown at the specified pixel offset
+         * from the centre of the target in place.
+         */
+        void zoom_at(const float& factor, const sf::Vector2f& pixel_offset) {
+            auto anchor = _center + pixel_offset / _zoom;
+            set_zoom(_zoom * factor);
+            _center = anchor - pixel_offset / _zoom;
+        }
+
+        /**
+         * Centres the camera on the bounds and zooms so that they fit inside a target of the specified size, leaving
+         * the specified margin in pixels on every side.
+         */
+        void frame(const sf::FloatRect& bounds, const sf::Vector2u& target_size, const float& margin_pixels = 0.0f) {
+            _center = sf::Vector2f(bounds.left + 0.5f * bounds.width, bounds.top + 0.5f * bounds.height);
+
+            float available_x = std::max(1.0f, (float)target_size.x - 2.0f * margin_pixels);
+            float available_y = std::max(1.0f, (float)target_size.y - 2.0f * margin_pixels);
+
+            if (bounds.width <= 0 && bounds.height <= 0) {
+                return;
+            }
+
+            float zoom_x = bounds.width > 0 ? available_x / bounds.width : max_zoom;
+            float zoom_y = bounds.height > 0 ? available_y / bounds.height : max_zoom;
+            set_zoom(std::min(zoom_x, zoom_y));
+        }
+
+        /**
+         * @return the view showing what the camera sees on a target of the specified size
+         */
+        [[nodiscard]] sf::View view(const sf::Vector2u& target_size) const {
+            return sf::View(_center, sf::Vector2f((float)target_size.x / _zoom, (float)target_size.y / _zoom));
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef RENDERING_FRAME_EXPORT_H
+#define RENDERING_FRAME_EXPORT_H
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace atk {
+
+    /**
+     * A single rendered frame, as tightly packed 8 bit RGBA rows from top to bottom.
+     */
+    struct Frame {
+        std::size_t index;
+        unsigned int width;
+        unsigned int height;
+        std::vector<sf::Uint8> pixels;
+    };
+
+    /**
+     * Destination for exported frames. write may be called concurrently from several writer threads and with
+     * frames out of order.
+     */
+    class FrameSink {
+    public:
+        virtual ~FrameSink() = default;
+
+        virtual void write(const Frame& frame) = 0;
+    };
+
+    /**
+     * Writes every frame to its own png file, frame_000000.png, frame_000001.png, ... in the specified directory.
+     */
+    class PngSequenceSink : public FrameSink {
+    private:
+        std::filesystem::path directory;
+
+    public:
+        explicit PngSequenceSink(std::filesystem::path directory) : directory(std::move(directory)) {
+            std::filesystem::create_directories(this->directory);
+        }
+
+        void write(const Frame& frame) override {
+            sf::Image image;
+            image.create(frame.width, frame.height, frame.pixels.data());
+
+            auto file_name = (std::stringstream() << "frame_" << std::setw(6) << std::setfill('0') << frame.index << ".png").str();
+            if (!image.saveToFile((directory / file_name).string())) {
+                throw std::runtime_error("Could not write frame " + file_name);
+            }
+        }
+    };
+
+    /**
+     * Writes all frames into a single uncompressed YUV4MPEG2 (4:4:4) stream, which can be piped into most encoders.
+     * Colour conversion runs on the calling writer thread; frames arriving out of order are held back until all
+     * earlier frames have been written.
+     */
+    class Y4mSink : public FrameSink {
+    private:
+        std::ofstream out;
+        float frames_per_second;
+        bool header_written = false;
+
+        std::mutex mutex;
+        std::size_t next_index = 0;
+        std::map<std::size_t, std::vector<sf::Uint8>> pending;
+
+    public:
+        Y4mSink(const std::filesystem::path& path, const float& frames_per_second) :
+                out(path, std::ios::binary),
+                frames_per_second(frames_per_second) {
+            if (!out) {
+                throw std::runtime_error("Could not open " + path.string() + " for writing.");
+            }
+        }
+
+        void write(const Frame& frame) override {
+            auto planes = to_yuv444(frame);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (!header_written) {
+                out << "YUV4MPEG2 W" << frame.width << " H" << frame.height
+                    << " F" << std::lround(frames_per_second * 1000.0f) << ":1000 Ip A1:1 C444\n";
+                header_written = true;
+            }
+
+            pending.emplace(frame.index, std::move(planes));
+            while (!pending.empty() && pending.begin()->first == next_index) {
+                auto &data = pending.begin()->second;
+                out << "FRAME\n";
+                out.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+                pending.erase(pending.begin());
+                next_index++;
+            }
+
+            if (!out) {
+                throw std::runtime_error("Could not write frame to y4m stream.");
+            }
+        }
+
+    private:
+        /**
+         * BT.601 limited range conversion into planar Y, Cb, Cr. Alpha is discarded.
+         */
+        static std::vector<sf::Uint8> to_yuv444(const Frame& frame) {
+            std::size_t plane_size = (std::size_t)frame.width * frame.height;
+            std::vector<sf::Uint8> result(plane_size * 3);
+
+            for (std::size_t i = 0; i < plane_size; i++) {
+                float r = frame.pixels[i * 4];
+                float g = frame.pixels[i * 4 + 1];
+                float b = frame.pixels[i * 4 + 2];
+
+                result[i] = to_byte(16.0f + (65.738f * r + 129.057f * g + 25.064f * b) / 256.0f);
+                result[plane_size + i] = to_byte(128.0f + (-37.945f * r - 74.494f * g + 112.439f * b) / 256.0f);
+                result[2 * plane_size + i] = to_byte(128.0f + (112.439f * r - 94.154f * g - 18.285f * b) / 256.0f);
+            }
+
+            return result;
+        }
+
+        static sf::Uint8 to_byte(const float& value) {
+            return (sf::Uint8)std::clamp(std::lround(value), 0l, 255l);
+        }
+    };
+
+    /**
+     * Hands frames to a pool of writer threads through a bounded ring buffer, so that the render loop only waits
+     * when the writers have fallen a full buffer behind. Errors raised by the sink are rethrown from the next
+     * submit or from finish.
+     */
+    class FrameExporter {
+    private:
+        std::shared_ptr<FrameSink> sink;
+
+        std::vector<Frame> ring;
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+        std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+
+        bool finishing = false;
+        std::exception_ptr error = nullptr;
+
+        std::vector<std::thread> writers;
+
+    public:
+        explicit FrameExporter(std::shared_ptr<FrameSink> sink,
+                               const std::size_t& capacity = 8,
+                               const std::size_t& writer_count = default_writer_count()) :
+                sink(std::move(sink)),
+                ring(std::max<std::size_t>(1, capacity)) {
+
+            for (std::size_t i = 0; i < std::max<std::size_t>(1, writer_count); i++) {
+                writers.emplace_back([this]() { run_writer(); });
+            }
+        }
+
+        ~FrameExporter() {
+            join();
+        }
+
+        void submit(Frame frame) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return count < ring.size() || error != nullptr; });
+
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+
+            if (finishing) {
+                throw std::runtime_error("Frame exporter already finished.");
+            }
+
+            ring[(head + count) % ring.size()] = std::move(frame);
+            count++;
+            not_empty.notify_one();
+        }
+
+        /**
+         * Blocks until every submitted frame has been written.
+         */
+        void finish() {
+            join();
+
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        static std::size_t default_writer_count() {
+            return std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+
+    private:
+        void join() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finishing = true;
+            }
+            not_empty.notify_all();
+
+            for (auto &w : writers) {
+                if (w.joinable()) {
+                    w.join();
+                }
+            }
+        }
+
+        void run_writer() {
+            while (true) {
+                Frame frame;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    not_empty.wait(lock, [this]() { return count > 0 || finishing; });
+
+                    if (count == 0) {
+                        return;
+                    }
+
+                    frame = std::move(ring[head]);
+                    head = (head + 1) % ring.size();
+                    count--;
+                }
+                not_full.notify_one();
+
+                try {
+                    sink->write(frame);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (error == nullptr) {
+                        error = std::current_exception();
+                    }
+                    not_full.notify_all();
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef RENDERING_LEVEL_OF_DETAIL_H
+#define RENDERING_LEVEL_OF_DETAIL_H
+
+#include <SFML/Graphics.hpp>
+
+#include <cmath>
+
+#include "../utils/transforms.h"
+
+namespace atk {
+
+    /**
+     * Thresholds, in pixels on screen, below which entities simplify their geometry, and helpers for finding how many
+     * pixels a local unit covers when drawn.
+     */
+    class LevelOfDetail {
+    public:
+        /**
+         * arrows shorter than this on screen are drawn without a head
+         */
+        inline static float arrow_head_min_pixels = 8.0f;
+
+        /**
+         * evenly sampled curves use no more samples than needed to keep them this far apart on screen
+         */
+        inline static float curve_sample_spacing_pixels = 2.0f;
+
+        /**
+         * @return pixels per unit of the target's current view, within the part of the target its viewport covers
+         */
+        static float view_scale(const sf::RenderTarget& target) {
+            const auto& view = target.getView();
+            return (float)target.getSize().x * view.getViewport().width / view.getSize().x;
+        }
+
+        /**
+         * @return pixels per local unit when drawn with the specified transform in the target's current view
+         */
+        static float pixels_per_unit(const sf::RenderTarget& target, const sf::Transform& transform) {
+            return view_scale(target) * TransformUtils::get_scale_factor(transform);
+        }
+
+        /**
+         * @return the scale rounded to a power of two, so that geometry depending on it is rebuilt only when zooming
+         * changes the scale by a factor of about two. 1 if the scale is degenerate.
+         */
+        static float quantize(const float& pixels_per_unit) {
+            if (!std::isfinite(pixels_per_unit) || pixels_per_unit <= 0) {
+                return 1.0f;
+            }
+
+            return std::exp2(std::round(std::log2(pixels_per_unit)));
+        }
+    };
+
+}
+
+#endif
@@ -2,6 +2,11 @@
 #define RENDERING_RENDERER_H
 
 #include "../scene_graph.h"
+#include "../entities/batchable.h"
+#include "vertex_batch.h"
+#include "frame_export.h"
+#include "camera.h"
+#include "level_of_detail.h"
 
 namespace atk {
     class Renderer {
@@ -11,6 +16,74 @@ namespace atk {
         };
 
         virtual Result render(SceneNode& scene) = 0;
+
+        /**
+         * Sets the camera the scene is viewed through, or nullptr to draw it in the target's default view.
+         */
+        void set_camera(std::shared_ptr<Camera> new_camera) {
+            camera = std::move(new_camera);
+        }
+
+        [[nodiscard]] const std::shared_ptr<Camera>& get_camera() const {
+            return camera;
+        }
+
+        /**
+         * @return true if the renderer can wait for input, letting the Director stop rendering while idle
+         */
+        [[nodiscard]] virtual bool can_wait_for_input() const {
+            return false;
+        }
+
+        /**
+         * Blocks until input arrives or the timeout elapses, or indefinitely for input if no timeout is specified.
+         * @return true if the input requires the scene to be rendered again, e.g. because the camera moved
+         */
+        virtual bool wait_for_input(const std::optional<float>& /* timeout_seconds */) {
+            return false;
+        }
+
+    protected:
+        std::shared_ptr<Camera> camera;
+
+        /**
+         * Draws the scene onto the target in z order, through the camera if one is set. If a batch is specified,
+         * Batchable drawables are collected into it and drawn with one call per shader state and z order instead of
+         * one call each. Drawables outside the view are culled.
+         */
+        void draw_scene(sf::RenderTarget& target, SceneNode& scene, VertexBatch* batch) {
+            target.setView(camera != nullptr ? camera->view(target.getSize()) : target.getDefaultView());
+
+            auto viewport = visible_area(target);
+
+            if (batch == nullptr) {
+                scene.render([&target](const sf::Drawable& d, const sf::Transform& t){
+                    target.draw(d, t);
+                }, nullptr, viewport);
+                return;
+            }
+
+            batch->set_view_scale(LevelOfDetail::view_scale(target));
+            scene.render([&target, batch](const sf::Drawable& d, const sf::Transform& t){
+                auto batchable = dynamic_cast<const Batchable*>(&d);
+                if (batchable != nullptr) {
+                    batchable->batch(*batch, t);
+                } else {
+                    // preserve ordering relative to anything batched before this drawable
+                    batch->flush(target);
+                    target.draw(d, t);
+                }
+            }, [&target, batch](int) {
+                batch->flush(target);
+            }, viewport);
+        }
+
+        /**
+         * @return the world space area shown by the target's current view, as an axis aligned box
+         */
+        static sf::FloatRect visible_area(const sf::RenderTarget& target) {
+            return target.getView().getInverseTransform().transformRect(sf::FloatRect(-1, -1, 2, 2));
+        }
     };
 
     class WindowRenderer: public Renderer {
@@ -21,6 +94,19 @@ namespace atk {
 
         bool debug;
 
+        bool batched = false;
+
+        VertexBatch vertex_batch;
+
+        /**
+         * last cursor position while dragging the camera
+         */
+        std::optional<sf::Vector2i> drag_origin;
+
+        static constexpr float ZOOM_STEP = 1.1f;
+        static constexpr float PAN_STEP = 50.0f;
+        static constexpr float WAIT_SLICE_SECONDS = 0.02f;
+
     public:
         WindowRenderer(int width, int height, const sf::Color& background_color, bool debug=false) :
         _background_color(background_color), debug(debug) {
@@ -31,7 +117,15 @@ namespace atk {
                     "Hello World",
                     sf::Style::Default,
                     settings);
-            //window->setFramerateLimit(60);
+            window->setFramerateLimit(60);
+        }
+
+        /**
+         * When enabled, Batchable drawables are collected into shared vertex buffers and drawn with one call per
+         * shader state and z order. Within a z order, drawables may then be drawn out of their traversal order.
+         */
+        void set_batched(const bool& new_batched) {
+            batched = new_batched;
         }
 
         Result render(SceneNode &scene) override {
@@ -41,16 +135,16 @@ namespace atk {
 
             sf::Event event;
             while (window->pollEvent(event)) {
-                if (event.type == sf::Event::Closed) {
-                    window->close();
-                }
+                handle_event(event);
+            }
+
+            if (!window->isOpen()) {
+                return Result {false};
             }
 
             window->clear(_background_color);
 
-            scene.render([this](const sf::Drawable& d, const sf::Transform& t){
-                window->draw(d, t);
-            });
+            draw_scene(*window, scene, batched ? &vertex_batch : nullptr);
 
             if (debug) {
                 sf::RectangleShape outline;
@@ -70,6 +164,208 @@ namespace atk {
 
             return Result{true};
         }
+
+        [[nodiscard]] bool can_wait_for_input() const override {
+            return true;
+        }
+
+        bool wait_for_input(const std::optional<float>& timeout_seconds) override {
+            bool redraw = false;
+            sf::Event event;
+
+            if (!timeout_seconds.has_value() || !std::isfinite(timeout_seconds.value())) {
+                // blocks without using the CPU until the window receives an event
+                if (window->waitEvent(event)) {
+                    redraw = handle_event(event);
+                }
+            } else {
+                // SFML cannot wait for an event with a timeout, so poll in slices short enough to feel responsive
+                sf::Clock clock;
+                bool received = false;
+                while (!received && clock.getElapsedTime().asSeconds() < timeout_seconds.value()) {
+                    if (window->pollEvent(event)) {
+                        received = true;
+                        redraw = handle_event(event);
+                    } else {
+                        auto remaining = timeout_seconds.value() - clock.getElapsedTime().asSeconds();
+                        sf::sleep(sf::seconds(std::clamp(remaining, 0.0f, WAIT_SLICE_SECONDS)));
+                    }
+                }
+            }
+
+            while (window->pollEvent(event)) {
+                redraw = handle_event(event) || redraw;
+            }
+
+            return redraw;
+        }
+
+    private:
+        /**
+         * @return true if the event requires the scene to be rendered again
+         */
+        bool handle_event(const sf::Event& event) {
+            switch (event.type) {
+                case sf::Event::Closed:
+                    window->close();
+                    return true;
+                case sf::Event::Resized:
+                case sf::Event::GainedFocus:
+                    return true;
+                default:
+                    return camera != nullptr && control_camera(event);
+            }
+        }
+
+        /**
+         * Mouse wheel and +/- zoom around the cursor or centre, dragging with the left button and the arrow keys pan.
+         * @return true if the camera moved
+         */
+        bool control_camera(const sf::Event& event) {
+            auto size = window->getSize();
+            auto centre = sf::Vector2f(0.5f * (float)size.x, 0.5f * (float)size.y);
+
+            auto center_before = camera->get_center();
+            auto zoom_before = camera->get_zoom();
+
+            switch (event.type) {
+                case sf::Event::MouseWheelScrolled: {
+                    auto cursor = sf::Vector2f((float)event.mouseWheelScroll.x, (float)event.mouseWheelScroll.y);
+                    camera->zoom_at(std::pow(ZOOM_STEP, event.mouseWheelScroll.delta), cursor - centre);
+                    break;
+                }
+                case sf::Event::MouseButtonPressed:
+                    if (event.mouseButton.button == sf::Mouse::Left) {
+                        drag_origin = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+                    }
+                    break;
+                case sf::Event::MouseButtonReleased:
+                    if (event.mouseButton.button == sf::Mouse::Left) {
+                        drag_origin = std::nullopt;
+                    }
+                    break;
+                case sf::Event::MouseMoved:
+                    if (drag_origin.has_value()) {
+                        auto position = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+                        camera->pan_pixels(sf::Vector2f(position - drag_origin.value()));
+                        drag_origin = position;
+                    }
+                    break;
+                case sf::Event::KeyPressed:
+                    switch (event.key.code) {
+                        case sf::Keyboard::Add:
+                        case sf::Keyboard::Equal:
+                            camera->zoom_at(ZOOM_STEP, sf::Vector2f(0, 0));
+                            break;
+                        case sf::Keyboard::Subtract:
+                        case sf::Keyboard::Hyphen:
+                            camera->zoom_at(1.0f / ZOOM_STEP, sf::Vector2f(0, 0));
+                            break;
+                        case sf::Keyboard::Left:
+                            camera->pan_pixels(sf::Vector2f(PAN_STEP, 0));
+                            break;
+                        case sf::Keyboard::Right:
+                            camera->pan_pixels(sf::Vector2f(-PAN_STEP, 0));
+                            break;
+                        case sf::Keyboard::Up:
+                            camera->pan_pixels(sf::Vector2f(0, PAN_STEP));
+                            break;
+                        case sf::Keyboard::Down:
+                            camera->pan_pixels(sf::Vector2f(0, -PAN_STEP));
+                            break;
+                        default:
+                            break;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            return camera->get_center() != center_before || camera->get_zoom() != zoom_before;
+        }
+    };
+
+    /**
+     * Renders into an offscreen texture instead of a window and passes every frame on to a FrameSink, for exporting
+     * animations without a display. Encoding and file output happen on the exporter's writer threads. Pair with a
+     * FixedStepTimer so that frames are spaced evenly in animation time rather than by how long rendering took.
+     */
+    class OffscreenRenderer: public Renderer {
+    private:
+        sf::RenderTexture texture;
+
+        sf::Color _background_color;
+
+        FrameExporter exporter;
+
+        std::size_t frame_index = 0;
+
+        std::optional<std::size_t> max_frames;
+
+        bool batched = false;
+
+        VertexBatch vertex_batch;
+
+    public:
+        OffscreenRenderer(unsigned int width,
+                          unsigned int height,
+                          const sf::Color& background_color,
+                          std::shared_ptr<FrameSink> sink,
+                          const std::size_t& writer_count = FrameExporter::default_writer_count()) :
+                _background_color(background_color),
+                exporter(std::move(sink), 2 * writer_count, writer_count) {
+            sf::ContextSettings settings;
+            settings.antialiasingLevel = 8;
+            if (!texture.create(width, height, settings)) {
+                throw std::runtime_error("Could not create offscreen render target.");
+            }
+        }
+
+        /**
+         * Once the specified number of frames have been exported, render reports failure so that playback stops.
+         */
+        void set_max_frames(const std::optional<std::size_t>& new_max_frames) {
+            max_frames = new_max_frames;
+        }
+
+        void set_batched(const bool& new_batched) {
+            batched = new_batched;
+        }
+
+        [[nodiscard]] std::size_t frame_count() const {
+            return frame_index;
+        }
+
+        /**
+         * Blocks until all frames rendered so far have been written out.
+         */
+        void finish() {
+            exporter.finish();
+        }
+
+        Result render(SceneNode &scene) override {
+            if (max_frames.has_value() && frame_index >= max_frames.value()) {
+                return Result {false};
+            }
+
+            texture.clear(_background_color);
+            draw_scene(texture, scene, batched ? &vertex_batch : nullptr);
+            texture.display();
+
+            // the read back is synchronous, everything after it is left to the writer threads
+            sf::Image image = texture.getTexture().copyToImage();
+            auto size = image.getSize();
+            const sf::Uint8* pixels = image.getPixelsPtr();
+
+            exporter.submit(Frame {
+                    frame_index,
+                    size.x,
+                    size.y,
+                    std::vector<sf::Uint8>(pixels, pixels + (std::size_t)size.x * size.y * 4)});
+            frame_index++;
+
+            return Result{true};
+        }
     };
 }
 
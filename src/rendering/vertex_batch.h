@@ -0,0 +1,137 @@
+#ifndef RENDERING_VERTEX_BATCH_H
+#define RENDERING_VERTEX_BATCH_H
+
+#include <SFML/Graphics.hpp>
+
+#include <array>
+#include <vector>
+#include "../entities/shader_cache.h"
+
+namespace atk {
+
+    /**
+     * Collects world space triangles grouped by the shader state needed to draw them, so that every group can be
+     * submitted with a single draw call. Vertex storage is retained between flushes to avoid per frame allocation.
+     */
+    class VertexBatch {
+    public:
+        using Uniforms = ShaderProgram::Uniforms;
+
+        /**
+         * Shader and uniform values shared by all triangles of a group. Groups using the same shader with different
+         * uniform values are kept apart. apply is invoked through the program before the group is drawn, which skips
+         * it if the program already holds those values.
+         */
+        struct State {
+            ShaderProgram* program = nullptr;
+            ShaderProgram::ApplyUniforms apply = nullptr;
+            Uniforms uniforms {};
+
+            bool operator==(const State&) const = default;
+        };
+
+    private:
+        struct Group {
+            State state;
+            std::vector<sf::Vertex> vertices;
+        };
+
+        /**
+         * groups are kept in the order they were first seen, so the relative order of shaders is stable across
+         * frames.
+         */
+        std::vector<Group> groups;
+
+        float _view_scale = 1.0f;
+
+    public:
+        /**
+         * pixels per world unit of the view the batch will be flushed in, for level of detail decisions
+         */
+        [[nodiscard]] float view_scale() const {
+            return _view_scale;
+        }
+
+        void set_view_scale(const float& view_scale) {
+            _view_scale = view_scale;
+        }
+
+        std::vector<sf::Vertex>& triangles(const State& state) {
+            for (auto &g : groups) {
+                if (g.state == state) {
+                    return g.vertices;
+                }
+            }
+
+            groups.push_back(Group {state, {}});
+            return groups.back().vertices;
+        }
+
+        /**
+         * Appends a triangle fan, transformed into world space, as a list of triangles.
+         */
+        void append_fan(const State& state, const sf::Vertex* vertices, std::size_t count, const sf::Transform& transform) {
+            if (count < 3) {
+                return;
+            }
+
+            auto &out = triangles(state);
+            sf::Vertex center = transformed(vertices[0], transform);
+            sf::Vertex previous = transformed(vertices[1], transform);
+            for (std::size_t i = 2; i < count; i++) {
+                sf::Vertex current = transformed(vertices[i], transform);
+                out.push_back(center);
+                out.push_back(previous);
+                out.push_back(current);
+                previous = current;
+            }
+        }
+
+        /**
+         * Appends a triangle strip, transformed into world space, as a list of triangles.
+         */
+        void append_strip(const State& state, const sf::Vertex* vertices, std::size_t count, const sf::Transform& transform) {
+            if (count < 3) {
+                return;
+            }
+
+            auto &out = triangles(state);
+            sf::Vertex v0 = transformed(vertices[0], transform);
+            sf::Vertex v1 = transformed(vertices[1], transform);
+            for (std::size_t i = 2; i < count; i++) {
+                sf::Vertex v2 = transformed(vertices[i], transform);
+                out.push_back(v0);
+                out.push_back(v1);
+                out.push_back(v2);
+                v0 = v1;
+                v1 = v2;
+            }
+        }
+
+        /**
+         * Draws every non empty group with one draw call each and empties them.
+         */
+        void flush(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default) {
+            for (auto &g : groups) {
+                if (g.vertices.empty()) {
+                    continue;
+                }
+
+                states.shader = g.state.program != nullptr ? &g.state.program->shader() : nullptr;
+                if (g.state.program != nullptr && g.state.apply != nullptr) {
+                    g.state.program->apply(g.state.apply, g.state.uniforms);
+                }
+
+                target.draw(&g.vertices[0], g.vertices.size(), sf::Triangles, states);
+                g.vertices.clear();
+            }
+        }
+
+    private:
+        static sf::Vertex transformed(const sf::Vertex& v, const sf::Transform& transform) {
+            return sf::Vertex(transform.transformPoint(v.position), v.color, v.texCoords);
+        }
+    };
+}
+
+#endif
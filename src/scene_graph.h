@@ -3,20 +3,35 @@
 
 #include <SFML/Graphics.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <map>
 #include <string>
 #include <sstream>
-#include <stack>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "entities/local_boundable.h"
+#include "rendering/cached_layer.h"
+#include "scene_storage.h"
+#include "utils/bounds.h"
 #include "utils/transforms.h"
+#include "utils/symbol.h"
 
 namespace atk {
 
-    class SceneNode : public std::enable_shared_from_this<SceneNode> {
+    class NodeHandle;
+
+    class SceneNode : public std::enable_shared_from_this<SceneNode>, private BoundsObserver {
     private:
         std::shared_ptr<sf::Drawable> sf_element = nullptr;
 
+        /**
+         * sf_element as a LocalBoundable, if it is one. Observed so geometry changes invalidate cached bounds.
+         */
+        LocalBoundable* _boundable = nullptr;
+
         // additional transfrom applied to the drawable, if possible
         sf::Transform _transform;
 
@@ -27,8 +42,107 @@ namespace atk {
 
         std::map<std::string, std::shared_ptr<SceneNode>> _children;
 
+        /**
+         * interned child names, pointing into _children. std::map values never move, so entries stay valid until
+         * the child is removed.
+         */
+        std::unordered_map<Symbol, std::shared_ptr<SceneNode>*, Symbol::Hash> _child_index;
+
+        /**
+         * incremented whenever a node is added or removed anywhere in this subtree
+         */
+        std::uint64_t _structure_version = 0;
+
         std::weak_ptr<SceneNode> _parent;
 
+        /**
+         * cached product of this node's and all parents' transforms. Only valid while _world_dirty is false. A node
+         * can only be clean if all of its parents are clean, so a dirty node implies a dirty subtree.
+         */
+        mutable sf::Transform _world_transform;
+        mutable sf::Transform _world_inverse;
+        mutable bool _world_dirty = true;
+        mutable bool _world_inverse_dirty = true;
+
+        /**
+         * incremented each time the world transform goes from clean to dirty. Observers that record the version after
+         * querying the world transform can compare versions later to tell whether it may have changed since.
+         */
+        std::uint64_t _world_version = 0;
+
+        /**
+         * Cached world bounds of this node alone and of its whole subtree. A cache is valid while its dirty flag is
+         * clear and the world transform version it was computed at still matches. Geometry, transform and structure
+         * changes set _bounds_dirty on the node and every ancestor. Drawables whose bounds follow other nodes are
+         * additionally rechecked when their bounds version differs from the one the cache was computed with, and
+         * drawables without bounds notifications on every query.
+         */
+        mutable sf::FloatRect _node_bounds;
+        mutable bool _node_bounds_dirty = true;
+        mutable std::uint64_t _node_bounds_version = 0;
+        mutable std::uint64_t _node_bounds_source_version = 0;
+
+        mutable sf::FloatRect _subtree_bounds;
+        mutable bool _bounds_dirty = true;
+        mutable bool _bounds_unversioned = false;
+        mutable std::uint64_t _bounds_version = 0;
+
+        /**
+         * drawable nodes of the subtree with external bounds dependencies, and their bounds versions when the subtree
+         * bounds were computed
+         */
+        mutable std::vector<std::pair<const SceneNode*, std::uint64_t>> _bounds_sources;
+
+        /**
+         * Drawable nodes of this subtree, bucketed by z order and in depth first order within a bucket. Rebuilt on
+         * the next render after a structural change (add/remove/clear/set_z_order) anywhere in the subtree; reused
+         * as-is otherwise. Entries are non-owning as the subtree keeps every listed node alive until it is changed.
+         */
+        std::map<int, std::vector<SceneNode*>> _render_queue;
+        bool _render_queue_dirty = true;
+
+        /**
+         * Set while this node is held in flat storage shared with the rest of its tree. The local transform, world
+         * transform and its version are then read from and written to the storage; _transform and the world caches
+         * above are only used again once the node is detached.
+         */
+        std::shared_ptr<SceneStorage> _storage;
+        SceneStorage::NodeId _storage_id = SceneStorage::NO_NODE;
+        mutable std::uint64_t _world_inverse_version = 0;
+
+        /**
+         * render queue of storage ids, used in place of _render_queue when this node is the root of flat storage.
+         */
+        std::map<int, std::vector<SceneStorage::NodeId>> _flat_render_queue;
+
+        /**
+         * Viewport culling state. _subtree_bounded is set when every drawable in the subtree reports bounds, so the
+         * subtree can be culled as a whole; it is refreshed along with the render queue. _visible_frame records the
+         * last culling pass that found this node visible.
+         */
+        bool _subtree_bounded = false;
+        std::uint64_t _visible_frame = 0;
+
+        inline static std::uint64_t cull_frame = 0;
+
+        /**
+         * Set while this subtree is a cached layer; drawn by the render traversal of any ancestor in place of the
+         * drawables of the subtree.
+         */
+        std::unique_ptr<CachedLayer> _layer;
+
+        /**
+         * content and world transform versions at which _layer_bounds was computed
+         */
+        mutable std::optional<std::pair<std::uint64_t, std::uint64_t>> _layer_bounds_key;
+        mutable sf::FloatRect _layer_bounds;
+
+        /**
+         * Incremented whenever anything in this subtree changes in a way that can alter how it is drawn: transforms,
+         * structure, z orders and changes reported by entities.
+         */
+        std::uint64_t _content_version = 0;
+
     public:
         explicit SceneNode(std::unique_ptr<sf::Drawable> drawable,
                   const int &z_order = 0) :
@@ -37,6 +151,10 @@ namespace atk {
                 sf_element(std::move(drawable)),
                 _z_order(z_order),
                 _parent(std::weak_ptr<SceneNode>()){
+            _boundable = dynamic_cast<LocalBoundable*>(sf_element.get());
+            if (_boundable != nullptr) {
+                _boundable->set_bounds_observer(this);
+            }
         }
 
         explicit SceneNode(const int &z_order = 0) :
@@ -47,6 +165,39 @@ namespace atk {
                 _parent(std::weak_ptr<SceneNode>()) {
         }
 
+        ~SceneNode() override {
+            if (_boundable != nullptr) {
+                _boundable->set_bounds_observer(nullptr);
+            }
+
+            if (_storage) {
+                // children that outlive this node become roots, as they would without storage
+                for (auto &kv : _children) {
+                    if (kv.second->_storage == _storage) {
+                        _storage->set_parent(kv.second->_storage_id, SceneStorage::NO_NODE);
+                    }
+                }
+                _storage->destroy(_storage_id);
+            }
+        }
+
+        /**
+         * Moves the state of this node and its subtree into flat storage. Nodes added below it later join the same
+         * storage and removed nodes leave it. Must be called on a root node.
+         */
+        void use_flat_storage() {
+            if (_parent.lock()) {
+                throw std::runtime_error("Flat storage can only be enabled on a root node");
+            }
+
+            if (_storage) {
+                return;
+            }
+
+            attach_storage(std::make_shared<SceneStorage>(), SceneStorage::NO_NODE);
+            invalidate_render_queue();
+        }
+
         const std::map<std::string, std::shared_ptr<SceneNode>>& children() const {
             return _children;
         }
@@ -58,9 +209,13 @@ namespace atk {
         void clear() {
             for (auto& kv : this->_children) {
                 kv.second->_parent = std::weak_ptr<SceneNode>();
+                kv.second->detach_storage();
+                kv.second->invalidate_world_transform();
             }
 
             this->_children.clear();
+            this->_child_index.clear();
+            structure_changed();
         }
 
         void remove(const std::string& id) {
@@ -69,7 +224,11 @@ namespace atk {
             }
 
             this->_children[id]->_parent = std::weak_ptr<SceneNode>();
+            this->_children[id]->detach_storage();
+            this->_children[id]->invalidate_world_transform();
             this->_children.erase(id);
+            this->_child_index.erase(Symbol(id));
+            structure_changed();
         }
 
         /**
@@ -126,9 +285,8 @@ namespace atk {
                 return text_ptr->getGlobalBounds();
             }
 
-            auto boundable_ptr = std::dynamic_pointer_cast<atk::LocalBoundable>(this->sf_element);
-            if (boundable_ptr != nullptr) {
-                return boundable_ptr->get_local_bounds();
+            if (_boundable != nullptr) {
+                return _boundable->get_local_bounds();
             }
 
             throw std::runtime_error("Object does not support bounds.");
@@ -138,8 +296,20 @@ namespace atk {
          * @return the bounding box, accounting for object transformation of this single node
          */
         sf::FloatRect world_bounds() const {
-            sf::FloatRect local_bounds = this->local_bounds();
-            return this->local_to_world_transform().transformRect(local_bounds);
+            if (_node_bounds_dirty
+                || _node_bounds_version != world_transform_version()
+                || drawable_bounds_unversioned()
+                || (drawable_bounds_external() && _node_bounds_source_version != _boundable->bounds_version())) {
+                sf::FloatRect local_bounds = this->local_bounds();
+                _node_bounds = this->local_to_world_transform().transformRect(local_bounds);
+                _node_bounds_version = world_transform_version();
+                if (drawable_bounds_external()) {
+                    _node_bounds_source_version = _boundable->bounds_version();
+                }
+                _node_bounds_dirty = false;
+            }
+
+            return _node_bounds;
         }
 
         /**
@@ -151,7 +321,7 @@ namespace atk {
             float dx = x - current_world_origin.x;
             float dy = y - current_world_origin.y;
 
-            _transform.translate(dx, dy);
+            transform().translate(dx, dy);
             //TransformUtils::set_translation_part(
             //        _transform,
             //        current_translation.first + dx,
@@ -219,7 +389,7 @@ namespace atk {
             auto current_translation_offset = world_to_local_transform().transformPoint(x, y);
 
             // determine the required translation vector
-            auto current_translation = TransformUtils::get_translation_part(_transform);
+            auto current_translation = TransformUtils::get_translation_part(std::as_const(*this).transform());
 
             // translation that must be applied to this node
             float dx = current_translation_offset.x - current_translation.first;
@@ -229,7 +399,7 @@ namespace atk {
                 c.second->transform().translate(-dx, -dy);
             }
 
-            _transform.translate(dx, dy);
+            transform().translate(dx, dy);
 
             auto bounds_after = world_bounds_recursive();
 
@@ -238,10 +408,30 @@ namespace atk {
             }
         }
 
+        /**
+         * @return union of world_bounds() over this subtree. Cached; only subtrees that changed are recomputed.
+         */
         sf::FloatRect world_bounds_recursive() const {
+            if (!_bounds_dirty
+                && _bounds_version == world_transform_version()
+                && !_bounds_unversioned
+                && bounds_sources_current()) {
+                return _subtree_bounds;
+            }
+
             auto this_bounds = world_bounds();
+            bool is_unversioned = drawable_bounds_unversioned();
+
+            _bounds_sources.clear();
+            if (drawable_bounds_external()) {
+                _bounds_sources.emplace_back(this, _boundable->bounds_version());
+            }
+
             for (const auto& c : _children) {
                 auto child_bounds = c.second->world_bounds_recursive();
+                is_unversioned = is_unversioned || c.second->_bounds_unversioned;
+                _bounds_sources.insert(
+                        _bounds_sources.end(), c.second->_bounds_sources.begin(), c.second->_bounds_sources.end());
 
                 float left = std::min(this_bounds.left, child_bounds.left);
                 float top = std::min(this_bounds.top, child_bounds.top);
@@ -255,10 +445,35 @@ namespace atk {
                 this_bounds = sf::FloatRect(left, top, width, height);
             }
 
+            _subtree_bounds = this_bounds;
+            _bounds_unversioned = is_unversioned;
+            _bounds_version = world_transform_version();
+            _bounds_dirty = false;
+
             return this_bounds;
         }
 
+        /**
+         * Mutable access to the local transform. The cached world transforms of this node and its subtree are
+         * invalidated, as the caller is assumed to modify the returned transform before the next world query.
+         */
         [[nodiscard]] sf::Transform &transform() {
+            invalidate_bounds();
+            mark_changed();
+
+            if (_storage) {
+                return _storage->local(_storage_id);
+            }
+
+            invalidate_world_transform();
+            return this->_transform;
+        }
+
+        [[nodiscard]] const sf::Transform &transform() const {
+            if (_storage) {
+                return std::as_const(*_storage).local(_storage_id);
+            }
+
             return this->_transform;
         }
 
@@ -272,33 +487,72 @@ namespace atk {
         /**
          * @return a transform that brings the world coordinate to local coordinate 0, 0
          */
-        sf::Transform world_to_local_transform() const {
-            return local_to_world_transform().getInverse();
+        const sf::Transform& world_to_local_transform() const {
+            if (_storage) {
+                auto version = _storage->world_version(_storage_id);
+                if (_world_inverse_dirty || version != _world_inverse_version) {
+                    _world_inverse = _storage->world(_storage_id).getInverse();
+                    _world_inverse_version = version;
+                    _world_inverse_dirty = false;
+                }
+
+                return _world_inverse;
+            }
+
+            if (_world_inverse_dirty || _world_dirty) {
+                _world_inverse = local_to_world_transform().getInverse();
+                _world_inverse_dirty = false;
+            }
+
+            return _world_inverse;
         }
 
         /**
          * @return transform that brings local coordinate 0, 0 to world position, applying all transforms of this node
-         * and parents.
+         * and parents. Cached until this node or one of its parents has its transform modified.
          */
-        sf::Transform local_to_world_transform() const {
-            std::stack<sf::Transform> transform_stack;
+        const sf::Transform& local_to_world_transform() const {
+            if (_storage) {
+                return _storage->world(_storage_id);
+            }
 
-            transform_stack.push(this->_transform);
+            if (_world_dirty) {
+                auto parent = _parent.lock();
+                _world_transform = parent ? parent->local_to_world_transform() * _transform : _transform;
+                _world_dirty = false;
+                _world_inverse_dirty = true;
+            }
+
+            return _world_transform;
+        }
 
-            auto parent = this->_parent;
-            while (parent.lock()) {
-                transform_stack.push(parent.lock()->_transform);
-                parent = parent.lock()->_parent;
+        [[nodiscard]] std::uint64_t world_transform_version() const {
+            if (_storage) {
+                return _storage->world_version(_storage_id);
             }
 
-            sf::Transform result = transform_stack.top();
-            transform_stack.pop();
-            while (!transform_stack.empty()) {
-                result = transform_stack.top() * result;
-                transform_stack.pop();
+            return _world_version;
+        }
+
+        /**
+         * Marks the cached world transforms of this node and all of its descendants as stale. Stops descending at
+         * nodes that are already dirty, since their subtrees must be dirty as well.
+         */
+        void invalidate_world_transform() {
+            if (_storage) {
+                _storage->mark_dirty(_storage_id);
+                return;
             }
 
-            return result;
+            if (_world_dirty) {
+                return;
+            }
+
+            _world_dirty = true;
+            _world_version++;
+            for (auto &kv : _children) {
+                kv.second->invalidate_world_transform();
+            }
         }
 
         [[nodiscard]] int z_order() const {
@@ -306,7 +560,98 @@ namespace atk {
         }
 
         void set_z_order(const int &z_order) {
-            _z_order = z_order;
+            if (_z_order != z_order) {
+                _z_order = z_order;
+                if (_storage) {
+                    _storage->set_z_order(_storage_id, z_order);
+                }
+                invalidate_render_queue();
+                mark_changed();
+            }
+        }
+
+        /**
+         * Marks this subtree as a cached layer. When an ancestor renders, the subtree is rasterised into an offscreen
+         * texture and composited as one sprite at this node's z order, until something inside it changes. Transform,
+         * structure and z order changes, and changes reported by entities, are detected; call mark_changed after
+         * changing a drawable that does not report them. Arrows inside a layer should
+         * only point at nodes inside it.
+         */
+        void set_cached_layer(const bool& cached) {
+            if (cached == (_layer != nullptr)) {
+                return;
+            }
+
+            if (cached) {
+                _layer = std::make_unique<CachedLayer>(
+                        [this](sf::RenderTarget& target, const sf::FloatRect& area) {
+                            render([&target](const sf::Drawable& d, const sf::Transform& t) {
+                                target.draw(d, t);
+                            }, nullptr, area);
+                        },
+                        [this]() -> std::optional<sf::FloatRect> {
+                            if (!_subtree_bounded) {
+                                return std::nullopt;
+                            }
+                            return layer_bounds();
+                        });
+            } else {
+                _layer = nullptr;
+            }
+
+            if (_storage) {
+                _storage->set_layer(_storage_id, _layer.get());
+            }
+
+            invalidate_render_queue();
+            mark_changed();
+        }
+
+        [[nodiscard]] bool is_cached_layer() const {
+            return _layer != nullptr;
+        }
+
+        /**
+         * @return world_bounds_recursive of a cached layer, cached for as long as neither its content version nor its
+         * world transform version change. Every change within a layer calls mark_changed and arrows within a layer only
+         * follow nodes within it, so unlike the subtree bounds this never has to visit the contents to stay valid.
+         */
+        sf::FloatRect layer_bounds() const {
+            std::pair<std::uint64_t, std::uint64_t> key(_content_version, world_transform_version());
+            if (_layer_bounds_key != key) {
+                _layer_bounds = world_bounds_recursive();
+                _layer_bounds_key = key;
+            }
+
+            return _layer_bounds;
+        }
+
+        /**
+         * Records that this node may be drawn differently. The content versions of the node and its ancestors are
+         * incremented and every cached layer containing it is invalidated. Called by the scene graph itself for the
+         * changes it can see; call it after changing a drawable that does not report its own changes.
+         */
+        void mark_changed() {
+            _content_version++;
+            if (_layer) {
+                _layer->invalidate();
+            }
+
+            auto parent = _parent.lock();
+            while (parent) {
+                parent->_content_version++;
+                if (parent->_layer) {
+                    parent->_layer->invalidate();
+                }
+                parent = parent->_parent.lock();
+            }
+        }
+
+        /**
+         * @return a version that changes whenever mark_changed is called on this node or anything below it
+         */
+        [[nodiscard]] std::uint64_t content_version() const {
+            return _content_version;
         }
 
         std::shared_ptr<SceneNode> add(const std::string &name) {
@@ -317,6 +662,10 @@ namespace atk {
 
             _children[name] = std::make_shared<SceneNode>(_z_order);
             _children[name]->_parent = shared_from_this();
+            join_storage(*_children[name]);
+            _children[name]->invalidate_world_transform();
+            _child_index[Symbol(name)] = &_children[name];
+            structure_changed();
             return _children[name];
         }
 
@@ -328,6 +677,10 @@ namespace atk {
 
             _children[name] = std::move(node); //std::make_shared<SceneNode>(std::move(drawable), _z_order);
             _children[name]->_parent = shared_from_this();
+            join_storage(*_children[name]);
+            _children[name]->invalidate_world_transform();
+            _child_index[Symbol(name)] = &_children[name];
+            structure_changed();
             return _children[name];
         }
 
@@ -339,6 +692,10 @@ namespace atk {
             return _children.contains(name);
         }
 
+        bool contains(const Symbol& name) const {
+            return _child_index.contains(name);
+        }
+
         std::shared_ptr<SceneNode> &get(const std::string &name) {
             if (_children.find(name) == _children.end()) {
                 throw std::runtime_error((std::stringstream() << "Child with name " << name << " not present.").str());
@@ -347,6 +704,25 @@ namespace atk {
             return _children[name];
         }
 
+        std::shared_ptr<SceneNode> &get(const Symbol &name) {
+            auto it = _child_index.find(name);
+            if (it == _child_index.end()) {
+                throw std::runtime_error((std::stringstream() << "Child with name " << name.str() << " not present.").str());
+            }
+
+            return *it->second;
+        }
+
+        /**
+         * @return a handle to the descendant at the specified '/' separated path of child names, which is looked up
+         * on first use and then cached until nodes are added to or removed from this subtree.
+         */
+        NodeHandle resolve(std::string_view path);
+
+        [[nodiscard]] std::uint64_t structure_version() const {
+            return _structure_version;
+        }
+
         template<typename T>
         void modify(const std::function<void(T &)> &callback) {
             if (sf_element == nullptr) {
@@ -385,46 +761,202 @@ namespace atk {
             }
         }
 
-        void render(const std::function<void(const sf::Drawable &, const sf::Transform &)> &visitor) {
-            // will be sorted according to z order
-            std::vector<std::shared_ptr<SceneNode>> nodes;
+        /**
+         * Visits every drawable of this subtree in z order. If specified, z_order_end is invoked with the z order of
+         * each bucket once all of its drawables have been visited. If a viewport is specified, drawables whose world
+         * bounds lie outside of it are skipped, culling whole subtrees where their cached bounds allow.
+         */
+        void render(const std::function<void(const sf::Drawable &, const sf::Transform &)> &visitor,
+                    const std::function<void(int)> &z_order_end = nullptr,
+                    const std::optional<sf::FloatRect> &viewport = std::nullopt) {
+            if (_storage && _storage->parent(_storage_id) == SceneStorage::NO_NODE) {
+                render_flat(visitor, z_order_end, viewport);
+                return;
+            }
+
+            if (_render_queue_dirty) {
+                rebuild_render_queue();
+            }
+
+            // layers render their contents from within the visitor, so the frame is held locally
+            auto frame = viewport ? ++cull_frame : 0;
+            if (viewport) {
+                mark_visible(*viewport, false, frame, this);
+            }
+
+            for (const auto &bucket : _render_queue) {
+                if (bucket.second.empty()) {
+                    continue;
+                }
 
-            std::stack<std::shared_ptr<SceneNode>> stack;
-            stack.push(shared_from_this());
-            while (!stack.empty()) {
-                auto top = stack.top();
-                nodes.push_back(top);
-                stack.pop();
+                for (const auto *s : bucket.second) {
+                    if (viewport && s->_visible_frame != frame) {
+                        continue;
+                    }
 
-                if (top == nullptr) {
-                    throw std::runtime_error("Internal error.");
+                    if (s->_layer && s != this) {
+                        visitor(*s->_layer, s->local_to_world_transform());
+                    } else {
+                        visitor(*s->sf_element, s->local_to_world_transform());
+                    }
                 }
 
-                for (auto &kv: top->_children) {
-                    std::shared_ptr<SceneNode> next = kv.second;
-                    stack.push(next);
+                if (z_order_end) {
+                    z_order_end(bucket.first);
                 }
             }
+        }
 
-            std::sort(nodes.begin(), nodes.end(), [](
-                    const std::shared_ptr<SceneNode>& a,
-                    const std::shared_ptr<SceneNode>& b) {
-                return a->_z_order < b->_z_order;
-            });
+    private:
+        void attach_storage(const std::shared_ptr<SceneStorage>& storage, const SceneStorage::NodeId& parent_id) {
+            _storage = storage;
+            _storage_id = storage->create(_transform, _z_order, sf_element.get(), _world_version);
+            storage->set_parent(_storage_id, parent_id);
+            storage->set_layer(_storage_id, _layer.get());
+
+            for (auto &kv : _children) {
+                kv.second->attach_storage(storage, _storage_id);
+            }
+        }
 
-            for (const auto &s: nodes) {
-                if (s->sf_element != nullptr) {
-                    auto tr = s->local_to_world_transform();
-                    auto tr_origin = tr.transformPoint(0, 0);
-                    //std::cout << "Rendering node.. 0,0 goes to: " << tr_origin.x << ", " << tr_origin.y << std::endl;
+        /**
+         * Moves this subtree back to per node state, children first so no stored node outlives its parent.
+         */
+        void detach_storage() {
+            if (!_storage) {
+                return;
+            }
+
+            for (auto &kv : _children) {
+                kv.second->detach_storage();
+            }
+
+            _transform = std::as_const(*_storage).local(_storage_id);
+
+            // continue from the stored version, so that bounds cached while stored are seen as stale
+            _world_version = _storage->world_version(_storage_id) + 1;
+            _storage->destroy(_storage_id);
+            _storage = nullptr;
+            _storage_id = SceneStorage::NO_NODE;
+
+            _world_dirty = true;
+            _world_inverse_dirty = true;
+        }
 
-                    visitor(*s->sf_element, s->local_to_world_transform());
+        /**
+         * brings a newly added child into this node's storage, or out of any other storage it was part of
+         */
+        void join_storage(SceneNode& child) {
+            if (child._storage) {
+                child.detach_storage();
+            }
+
+            if (_storage) {
+                child.attach_storage(_storage, _storage_id);
+            }
+        }
+
+        void render_flat(const std::function<void(const sf::Drawable &, const sf::Transform &)> &visitor,
+                         const std::function<void(int)> &z_order_end,
+                         const std::optional<sf::FloatRect> &viewport) {
+            if (_render_queue_dirty) {
+                for (auto &bucket : _flat_render_queue) {
+                    bucket.second.clear();
+                }
+
+                collect_storage_ids(&_flat_render_queue, this);
+                _render_queue_dirty = false;
+            }
+
+            _storage->propagate();
+
+            auto frame = viewport ? ++cull_frame : 0;
+            if (viewport) {
+                mark_visible(*viewport, false, frame, this);
+            }
+
+            for (const auto &bucket : _flat_render_queue) {
+                if (bucket.second.empty()) {
+                    continue;
+                }
+
+                for (auto id : bucket.second) {
+                    if (viewport && _storage->visible_frame(id) != frame) {
+                        continue;
+                    }
+
+                    auto layer = _storage->layer(id);
+                    if (layer != nullptr && id != _storage_id) {
+                        visitor(*layer, _storage->world(id));
+                    } else {
+                        visitor(*_storage->drawable(id), _storage->world(id));
+                    }
+                }
+
+                if (z_order_end) {
+                    z_order_end(bucket.first);
                 }
             }
         }
 
-    private:
+        /**
+         * Adds the drawables of this subtree to the queue, or only this node if it is a cached layer other than the
+         * root being rendered. Nothing is added below a layer, but the flags used for culling are still refreshed.
+         */
+        void collect_storage_ids(std::map<int, std::vector<SceneStorage::NodeId>> *queue, const SceneNode* root) {
+            bool as_layer = _layer && this != root;
+            if (queue != nullptr && (as_layer || sf_element != nullptr)) {
+                (*queue)[_storage->z_order(_storage_id)].push_back(_storage_id);
+            }
+
+            _subtree_bounded = supports_bounds();
+            for (auto &kv : _children) {
+                kv.second->collect_storage_ids(as_layer ? nullptr : queue, root);
+                _subtree_bounded = _subtree_bounded && kv.second->_subtree_bounded;
+            }
+        }
 
+        /**
+         * Stamps every node of this subtree whose bounds overlap the viewport with the specified cull frame. Subtrees
+         * entirely outside the viewport are skipped without visiting their children, and subtrees entirely inside it
+         * are stamped without testing any further bounds. Drawables that do not report bounds are always visible.
+         * Cached layers below the root are stamped as a whole.
+         */
+        void mark_visible(const sf::FloatRect &viewport, bool inside, const std::uint64_t& frame, const SceneNode* root) {
+            bool as_layer = _layer && this != root;
+
+            if (!inside && _subtree_bounded) {
+                auto bounds = as_layer ? layer_bounds() : world_bounds_recursive();
+                if (!BoundsUtil::overlaps(bounds, viewport)) {
+                    return;
+                }
+
+                inside = BoundsUtil::contains(viewport, bounds);
+            }
+
+            if (as_layer || inside || !supports_bounds() || BoundsUtil::overlaps(world_bounds(), viewport)) {
+                _visible_frame = frame;
+                if (_storage) {
+                    _storage->set_visible_frame(_storage_id, frame);
+                }
+            }
+
+            if (as_layer) {
+                return;
+            }
+
+            for (auto &kv : _children) {
+                kv.second->mark_visible(viewport, inside, frame, root);
+            }
+        }
+
+        [[nodiscard]] bool supports_bounds() const {
+            return sf_element == nullptr
+                   || _boundable != nullptr
+                   || dynamic_cast<const sf::Shape*>(sf_element.get()) != nullptr
+                   || dynamic_cast<const sf::Sprite*>(sf_element.get()) != nullptr
+                   || dynamic_cast<const sf::Text*>(sf_element.get()) != nullptr;
+        }
 
         void set_parent(const std::shared_ptr<SceneNode>& scene_node) {
             if (this->_parent.lock()) {
@@ -432,8 +964,176 @@ namespace atk {
             }
 
             this->_parent = scene_node;
+            invalidate_world_transform();
+        }
+
+        /**
+         * Records that a child was added or removed: the structure version and render queue of this node and all of
+         * its ancestors are updated.
+         */
+        void structure_changed() {
+            _structure_version++;
+            _render_queue_dirty = true;
+            _bounds_dirty = true;
+            mark_changed();
+
+            auto parent = _parent.lock();
+            while (parent) {
+                parent->_structure_version++;
+                parent->_render_queue_dirty = true;
+                parent->_bounds_dirty = true;
+                parent = parent->_parent.lock();
+            }
+        }
+
+        /**
+         * Marks the cached subtree bounds of this node and its ancestors as stale. Stops at the first node that is
+         * already stale, since the ancestors of a stale node are always stale as well.
+         */
+        void invalidate_bounds() {
+            if (_bounds_dirty) {
+                return;
+            }
+
+            _bounds_dirty = true;
+            auto parent = _parent.lock();
+            while (parent && !parent->_bounds_dirty) {
+                parent->_bounds_dirty = true;
+                parent = parent->_parent.lock();
+            }
+        }
+
+        void local_bounds_changed() override {
+            _node_bounds_dirty = true;
+            invalidate_bounds();
+            mark_changed();
+        }
+
+        void local_appearance_changed() override {
+            mark_changed();
+        }
+
+        /**
+         * @return true if the drawable's bounds are not reported through LocalBoundable, so they may change at any time
+         */
+        [[nodiscard]] bool drawable_bounds_unversioned() const {
+            return sf_element != nullptr && _boundable == nullptr;
+        }
+
+        [[nodiscard]] bool drawable_bounds_external() const {
+            return _boundable != nullptr && _boundable->has_external_bounds_dependencies();
+        }
+
+        /**
+         * @return true if no drawable the cached subtree bounds follow has a different bounds version since
+         */
+        [[nodiscard]] bool bounds_sources_current() const {
+            for (const auto& [node, version] : _bounds_sources) {
+                if (node->_boundable->bounds_version() != version) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * Marks the render queues of this node and all of its ancestors as stale, as any of them may be rendered.
+         */
+        void invalidate_render_queue() {
+            _render_queue_dirty = true;
+
+            auto parent = _parent.lock();
+            while (parent) {
+                parent->_render_queue_dirty = true;
+                parent = parent->_parent.lock();
+            }
+        }
+
+        void rebuild_render_queue() {
+            // buckets are cleared rather than erased so their capacity is reused
+            for (auto &bucket : _render_queue) {
+                bucket.second.clear();
+            }
+
+            collect_drawables(&_render_queue, this);
+
+            _render_queue_dirty = false;
+        }
+
+        /**
+         * see collect_storage_ids
+         */
+        void collect_drawables(std::map<int, std::vector<SceneNode*>> *queue, const SceneNode* root) {
+            bool as_layer = _layer && this != root;
+            if (queue != nullptr && (as_layer || sf_element != nullptr)) {
+                (*queue)[_z_order].push_back(this);
+            }
+
+            _subtree_bounded = supports_bounds();
+            for (auto &kv : _children) {
+                kv.second->collect_drawables(as_layer ? nullptr : queue, root);
+                _subtree_bounded = _subtree_bounded && kv.second->_subtree_bounded;
+            }
+        }
+    };
+
+    /**
+     * Path to a descendant of a node. The node is resolved by interned name lookups on first use and cached until the
+     * structure version of the root changes, so repeated access costs one comparison.
+     */
+    class NodeHandle {
+    private:
+        std::weak_ptr<SceneNode> root;
+        std::vector<Symbol> segments;
+
+        mutable std::weak_ptr<SceneNode> cached;
+        mutable std::uint64_t cached_version = 0;
+
+    public:
+        NodeHandle(const std::shared_ptr<SceneNode>& root, std::string_view path) : root(root) {
+            while (!path.empty()) {
+                auto end = path.find('/');
+                auto segment = path.substr(0, end);
+                if (!segment.empty()) {
+                    segments.emplace_back(segment);
+                }
+                path = end == std::string_view::npos ? std::string_view() : path.substr(end + 1);
+            }
+        }
+
+        /**
+         * @return the node at the path. Throws if the root no longer exists or the path is not present.
+         */
+        std::shared_ptr<SceneNode> get() const {
+            auto r = root.lock();
+            if (!r) {
+                throw std::runtime_error("Root of node handle no longer exists");
+            }
+
+            auto node = cached.lock();
+            if (node && cached_version == r->structure_version()) {
+                return node;
+            }
+
+            node = r;
+            for (const auto &segment : segments) {
+                node = node->get(segment);
+            }
+
+            cached = node;
+            cached_version = r->structure_version();
+            return node;
+        }
+
+        std::shared_ptr<SceneNode> operator->() const {
+            return get();
         }
     };
+
+    inline NodeHandle SceneNode::resolve(std::string_view path) {
+        return NodeHandle(shared_from_this(), path);
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,266 @@
+#ifndef SCENE_STORAGE_H
+#define SCENE_STORAGE_H
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace atk {
+
+    /**
+     * Flat storage for the per node state of a scene graph, addressed by integer ids that stay valid for as long as
+     * the node is stored. Transforms, parents, z orders and drawables live in parallel arrays; world transforms are
+     * propagated by a single linear scan over the nodes in order of depth. SceneNode forwards to this when flat
+     * storage is enabled on its root.
+     */
+    class SceneStorage {
+    public:
+        using NodeId = std::uint32_t;
+        static constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+    private:
+        std::vector<sf::Transform> _local;
+        std::vector<sf::Transform> _world;
+        std::vector<NodeId> _parent;
+        std::vector<int> _z_order;
+        std::vector<sf::Drawable*> _drawable;
+        std::vector<sf::Drawable*> _layer;
+        std::vector<std::uint64_t> _world_version;
+        std::vector<std::uint8_t> _dirty;
+        std::vector<std::uint8_t> _alive;
+        std::vector<std::uint64_t> _visible_frame;
+
+        std::vector<NodeId> free_ids;
+
+        /**
+         * live nodes sorted by depth, so every parent precedes its children. Rebuilt after parents change.
+         */
+        std::vector<NodeId> depth_order;
+        bool depth_order_dirty = false;
+
+        bool any_dirty = false;
+
+        // scratch used when rebuilding depth_order
+        std::vector<std::uint32_t> depths;
+        std::vector<std::uint32_t> depth_counts;
+
+    public:
+        /**
+         * @param world_version version the node had before joining, so versions keep increasing across storages
+         */
+        NodeId create(const sf::Transform& local, const int& z_order, sf::Drawable* drawable,
+                      const std::uint64_t& world_version = 0) {
+            NodeId id;
+            if (!free_ids.empty()) {
+                id = free_ids.back();
+                free_ids.pop_back();
+            } else {
+                id = (NodeId)_local.size();
+                _local.emplace_back();
+                _world.emplace_back();
+                _parent.push_back(NO_NODE);
+                _z_order.push_back(0);
+                _drawable.push_back(nullptr);
+                _layer.push_back(nullptr);
+                _world_version.push_back(0);
+                _dirty.push_back(0);
+                _alive.push_back(0);
+                _visible_frame.push_back(0);
+            }
+
+            _local[id] = local;
+            _parent[id] = NO_NODE;
+            _z_order[id] = z_order;
+            _drawable[id] = drawable;
+            _layer[id] = nullptr;
+            _alive[id] = 1;
+            _visible_frame[id] = 0;
+            _world_version[id] = world_version;
+            mark_dirty(id);
+            depth_order_dirty = true;
+
+            return id;
+        }
+
+        /**
+         * Releases the id for reuse. Children must have been given a new parent or released first.
+         */
+        void destroy(const NodeId& id) {
+            _alive[id] = 0;
+            _drawable[id] = nullptr;
+            _layer[id] = nullptr;
+            _parent[id] = NO_NODE;
+            _dirty[id] = 0;
+            free_ids.push_back(id);
+            depth_order_dirty = true;
+        }
+
+        void set_parent(const NodeId& id, const NodeId& parent) {
+            _parent[id] = parent;
+            mark_dirty(id);
+            depth_order_dirty = true;
+        }
+
+        [[nodiscard]] NodeId parent(const NodeId& id) const {
+            return _parent[id];
+        }
+
+        /**
+         * Mutable access to the local transform. The world transforms of the node and its subtree are recomputed on
+         * the next world query.
+         */
+        sf::Transform& local(const NodeId& id) {
+            mark_dirty(id);
+            return _local[id];
+        }
+
+        [[nodiscard]] const sf::Transform& local(const NodeId& id) const {
+            return _local[id];
+        }
+
+        const sf::Transform& world(const NodeId& id) {
+            propagate();
+            return _world[id];
+        }
+
+        std::uint64_t world_version(const NodeId& id) {
+            propagate();
+            return _world_version[id];
+        }
+
+        [[nodiscard]] int z_order(const NodeId& id) const {
+            return _z_order[id];
+        }
+
+        void set_z_order(const NodeId& id, const int& z_order) {
+            _z_order[id] = z_order;
+        }
+
+        [[nodiscard]] sf::Drawable* drawable(const NodeId& id) const {
+            return _drawable[id];
+        }
+
+        /**
+         * drawn in place of the node's subtree when an ancestor renders, see SceneNode::set_cached_layer
+         */
+        [[nodiscard]] sf::Drawable* layer(const NodeId& id) const {
+            return _layer[id];
+        }
+
+        void set_layer(const NodeId& id, sf::Drawable* layer) {
+            _layer[id] = layer;
+        }
+
+        /**
+         * the last culling pass that found the node inside the viewport, see SceneNode::render
+         */
+        [[nodiscard]] std::uint64_t visible_frame(const NodeId& id) const {
+            return _visible_frame[id];
+        }
+
+        void set_visible_frame(const NodeId& id, const std::uint64_t& frame) {
+            _visible_frame[id] = frame;
+        }
+
+        void mark_dirty(const NodeId& id) {
+            _dirty[id] = 1;
+            any_dirty = true;
+        }
+
+        /**
+         * Recomputes the world transform of every dirty node and every node below one, in one pass over depth_order.
+         * Each recomputed node has its world version incremented.
+         */
+        void propagate() {
+            if (!any_dirty) {
+                return;
+            }
+
+            if (depth_order_dirty) {
+                rebuild_depth_order();
+            }
+
+            for (auto id : depth_order) {
+                auto p = _parent[id];
+                if (p != NO_NODE && _dirty[p]) {
+                    _dirty[id] = 1;
+                }
+
+                if (_dirty[id]) {
+                    _world[id] = p == NO_NODE ? _local[id] : _world[p] * _local[id];
+                    _world_version[id]++;
+                }
+            }
+
+            for (auto id : depth_order) {
+                _dirty[id] = 0;
+            }
+
+            any_dirty = false;
+        }
+
+    private:
+        /**
+         * counting sort of the live nodes by depth
+         */
+        void rebuild_depth_order() {
+            const NodeId UNKNOWN = NO_NODE;
+            depths.assign(_local.size(), UNKNOWN);
+            depth_counts.clear();
+
+            for (NodeId id = 0; id < (NodeId)_local.size(); id++) {
+                if (_alive[id]) {
+                    auto d = depth(id);
+                    if (d >= depth_counts.size()) {
+                        depth_counts.resize(d + 1, 0);
+                    }
+                    depth_counts[d]++;
+                }
+            }
+
+            std::uint32_t offset = 0;
+            for (auto &c : depth_counts) {
+                auto count = c;
+                c = offset;
+                offset += count;
+            }
+
+            depth_order.resize(offset);
+            for (NodeId id = 0; id < (NodeId)_local.size(); id++) {
+                if (_alive[id]) {
+                    depth_order[depth_counts[depths[id]]++] = id;
+                }
+            }
+
+            depth_order_dirty = false;
+        }
+
+        /**
+         * depth of the node, memoized in depths. Walks up to the nearest ancestor of known depth and fills in the
+         * path on the way back.
+         */
+        std::uint32_t depth(const NodeId& id) {
+            NodeId top = id;
+            std::uint32_t steps = 0;
+            while (depths[top] == NO_NODE && _parent[top] != NO_NODE) {
+                top = _parent[top];
+                steps++;
+            }
+
+            std::uint32_t top_depth = depths[top] != NO_NODE ? depths[top] : 0;
+            depths[top] = top_depth;
+
+            NodeId n = id;
+            for (std::uint32_t d = top_depth + steps; n != top; d--) {
+                depths[n] = d;
+                n = _parent[n];
+            }
+
+            return depths[id];
+        }
+    };
+}
+
+#endif
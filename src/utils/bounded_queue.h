@@ -0,0 +1,101 @@
+#ifndef UTILS_BOUNDED_QUEUE_H
+#define UTILS_BOUNDED_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace atk {
+
+    /**
+     * Ring buffer handing values from producer threads to consumer threads. Producers wait while it is full and
+     * consumers while it is empty. Once closed, push refuses new values and pop drains the remaining ones before
+     * reporting the end. An error passed to close is rethrown from pop after the values before it were taken.
+     */
+    template<typename T>
+    class BoundedQueue {
+    private:
+        std::vector<std::optional<T>> ring;
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+        std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+
+        bool closed = false;
+        std::exception_ptr error = nullptr;
+
+    public:
+        explicit BoundedQueue(const std::size_t& capacity) : ring(std::max<std::size_t>(1, capacity)) {
+        }
+
+        /**
+         * Blocks until there is room for the value.
+         * @return false if the queue was closed, in which case the value is dropped
+         */
+        bool push(T value) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return count < ring.size() || closed; });
+
+            if (closed) {
+                return false;
+            }
+
+            ring[(head + count) % ring.size()] = std::move(value);
+            count++;
+            not_empty.notify_one();
+            return true;
+        }
+
+        /**
+         * Blocks until a value is available.
+         * @return the oldest value, or nullopt once the queue is closed and empty
+         */
+        std::optional<T> pop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this]() { return count > 0 || closed; });
+
+            if (count == 0) {
+                if (error != nullptr) {
+                    std::rethrow_exception(error);
+                }
+                return std::nullopt;
+            }
+
+            std::optional<T> value = std::move(ring[head]);
+            ring[head] = std::nullopt;
+            head = (head + 1) % ring.size();
+            count--;
+            not_full.notify_one();
+
+            return value;
+        }
+
+        /**
+         * Wakes every waiting thread. Values already queued can still be popped.
+         */
+        void close(std::exception_ptr new_error = nullptr) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+                if (error == nullptr) {
+                    error = new_error;
+                }
+            }
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+
+        [[nodiscard]] std::size_t size() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return count;
+        }
+    };
+
+}
+
+#endif
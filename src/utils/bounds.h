@@ -13,7 +13,23 @@ namespace atk {
             float bottom = std::max(r0.top + r0.height, r1.top + r1.height);
             float right = std::max(r0.left + r0.width, r1.left + r1.width);
 
-            return sf::FloatRect(top, left, bottom - top, right - left);
+            return sf::FloatRect(left, top, right - left, bottom - top);
+        }
+
+        /**
+         * Like FloatRect::intersects, but rectangles that only touch, or have no width or height, still overlap.
+         */
+        static bool overlaps(const sf::FloatRect& r0, const sf::FloatRect& r1) {
+            return r0.left <= r1.left + r1.width && r1.left <= r0.left + r0.width
+                   && r0.top <= r1.top + r1.height && r1.top <= r0.top + r0.height;
+        }
+
+        /**
+         * @return true if inner lies entirely within outer
+         */
+        static bool contains(const sf::FloatRect& outer, const sf::FloatRect& inner) {
+            return outer.left <= inner.left && inner.left + inner.width <= outer.left + outer.width
+                   && outer.top <= inner.top && inner.top + inner.height <= outer.top + outer.height;
         }
     };
 }
@@ -0,0 +1,68 @@
+#ifndef UTILS_SYMBOL_H
+#define UTILS_SYMBOL_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace atk {
+
+    /**
+     * Interned string. Symbols compare and hash as integers; each distinct text is stored once in a process wide
+     * table and never released.
+     */
+    class Symbol {
+    private:
+        std::uint32_t _id;
+
+        struct Table {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::uint32_t> ids;
+            std::deque<std::string> names;
+        };
+
+        static Table& table() {
+            static Table t;
+            return t;
+        }
+
+    public:
+        explicit Symbol(std::string_view name) {
+            auto &t = table();
+            std::lock_guard lock(t.mutex);
+
+            auto it = t.ids.find(std::string(name));
+            if (it != t.ids.end()) {
+                _id = it->second;
+                return;
+            }
+
+            _id = (std::uint32_t)t.names.size();
+            t.names.emplace_back(name);
+            t.ids.emplace(t.names.back(), _id);
+        }
+
+        [[nodiscard]] std::uint32_t id() const {
+            return _id;
+        }
+
+        [[nodiscard]] const std::string& str() const {
+            auto &t = table();
+            std::lock_guard lock(t.mutex);
+            return t.names[_id];
+        }
+
+        bool operator==(const Symbol&) const = default;
+
+        struct Hash {
+            std::size_t operator()(const Symbol& s) const {
+                return s._id;
+            }
+        };
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define UTIL_TRANSFORMS_H
 
 #include <SFML/Graphics.hpp>
+#include <cmath>
 
 namespace atk {
 
@@ -19,6 +20,14 @@ namespace atk {
             t.translate(dx - position.first, dy - position.second);
         }
 
+        /**
+         * @return the factor areas are scaled by, square rooted. For similarity transforms this is the uniform scale.
+         */
+        static float get_scale_factor(const sf::Transform& t) {
+            const float* m = t.getMatrix();
+            return std::sqrt(std::abs(m[0] * m[5] - m[1] * m[4]));
+        }
+
     };
 
 }